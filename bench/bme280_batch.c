@@ -0,0 +1,157 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "device/bme280.h"
+#include "interface/spi.h"
+#include "simulator/bme280_sim.h"
+#include "utility/clock.h"
+
+#ifdef BME280_FLOAT_ENABLE
+typedef double temperature_t;
+typedef double pressure_t;
+typedef double humidity_t;
+#else
+typedef int32_t temperature_t;
+typedef uint32_t pressure_t;
+typedef uint32_t humidity_t;
+#endif
+
+static uint32_t const sample_count = 1 << 16;
+static uint32_t const round_count = 64;
+static uint32_t const verify_count = 1 << 20;
+
+static uint32_t random_state = 0x2545F491;
+
+static uint32_t randomNext(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+int main(void) {
+    // Initialize simulated bme280 for its calibration data
+    struct bme280_sim_t sim;
+    bme280SimInitialize(&sim, NULL);
+    struct spi_settings_t spi_settings = {
+        .backend = &bme280_sim_backend,
+        .backend_data = &sim,
+    };
+    spi_device_t spi_device = spiInitialize(&spi_settings);
+    struct bme280_t device;
+    bme280Initialize(&device, spi_device);
+
+    // Generate raw samples around typical indoor conditions
+    uint32_t* raw_temperature = malloc(sample_count * sizeof(uint32_t));
+    uint32_t* raw_pressure = malloc(sample_count * sizeof(uint32_t));
+    uint32_t* raw_humidity = malloc(sample_count * sizeof(uint32_t));
+    temperature_t* temperature = malloc(sample_count * sizeof(temperature_t));
+    pressure_t* pressure = malloc(sample_count * sizeof(pressure_t));
+    humidity_t* humidity = malloc(sample_count * sizeof(humidity_t));
+    for (uint32_t i = 0; i < sample_count; i++) {
+        raw_temperature[i] = 480000 + randomNext() % 80000;
+        raw_pressure[i] = 380000 + randomNext() % 80000;
+        raw_humidity[i] = 20000 + randomNext() % 20000;
+    }
+
+    // Compensate one sample at a time
+    uint64_t start = clockGetTime();
+    for (uint32_t round = 0; round < round_count; round++) {
+        for (uint32_t i = 0; i < sample_count; i++) {
+            struct bme280_data_t data = {
+                .temperature = raw_temperature[i],
+                .pressure = raw_pressure[i],
+                .humidity = raw_humidity[i],
+            };
+            temperature[i] = bme280CalculateTemperature(&device, &data);
+            pressure[i] = bme280CalculatePressure(&device, &data);
+            humidity[i] = bme280CalculateHumidity(&device, &data);
+        }
+    }
+    uint64_t scalar_time = clockGetTime() - start;
+
+    // Compensate one sample at a time without touching the device
+    start = clockGetTime();
+    for (uint32_t round = 0; round < round_count; round++) {
+        for (uint32_t i = 0; i < sample_count; i++) {
+            struct bme280_data_t data = {
+                .temperature = raw_temperature[i],
+                .pressure = raw_pressure[i],
+                .humidity = raw_humidity[i],
+            };
+            struct bme280_measurement_t measurement;
+            bme280Compensate(&device.compensation, &data, &measurement);
+            temperature[i] = measurement.temperature;
+            pressure[i] = measurement.pressure;
+            humidity[i] = measurement.humidity;
+        }
+    }
+    uint64_t fused_time = clockGetTime() - start;
+
+    // Compensate all samples in one batch
+    start = clockGetTime();
+    for (uint32_t round = 0; round < round_count; round++) {
+        bme280CompensateBatch(&device, raw_temperature, raw_pressure,
+                              raw_humidity, temperature, pressure, humidity,
+                              sample_count);
+    }
+    uint64_t batch_time = clockGetTime() - start;
+
+    double total = (double)sample_count * round_count;
+    printf("{\"name\":\"bme280_batch\",\"variant\":\"scalar\","
+           "\"samples\":%.0f,\"ns_per_sample\":%.2f,"
+           "\"samples_per_s\":%.0f}\n",
+           total, scalar_time / total, total * 1e9 / scalar_time);
+    printf("{\"name\":\"bme280_batch\",\"variant\":\"fused\","
+           "\"samples\":%.0f,\"ns_per_sample\":%.2f,"
+           "\"samples_per_s\":%.0f}\n",
+           total, fused_time / total, total * 1e9 / fused_time);
+    printf("{\"name\":\"bme280_batch\",\"variant\":\"batch\","
+           "\"samples\":%.0f,\"ns_per_sample\":%.2f,"
+           "\"samples_per_s\":%.0f}\n",
+           total, batch_time / total, total * 1e9 / batch_time);
+    fflush(stdout);
+
+    // Verify against the scalar functions over every 20 bit temperature and
+    // pressure and every 16 bit humidity, the skipped values 0x80000 and
+    // 0x8000 included. Odd multipliers permute the pressure and humidity.
+    uint32_t mismatch = 0;
+    for (uint32_t offset = 0; offset < verify_count; offset += sample_count) {
+        for (uint32_t i = 0; i < sample_count; i++) {
+            uint32_t index = offset + i;
+            raw_temperature[i] = index;
+            raw_pressure[i] = (index * 0x9E3B5) & (verify_count - 1);
+            raw_humidity[i] = (index * 0x6F4D) & 0xFFFF;
+        }
+        bme280CompensateBatch(&device, raw_temperature, raw_pressure,
+                              raw_humidity, temperature, pressure, humidity,
+                              sample_count);
+        for (uint32_t i = 0; i < sample_count; i++) {
+            struct bme280_data_t data = {
+                .temperature = raw_temperature[i],
+                .pressure = raw_pressure[i],
+                .humidity = raw_humidity[i],
+            };
+            if (bme280CalculateTemperature(&device, &data) != temperature[i] ||
+                bme280CalculatePressure(&device, &data) != pressure[i] ||
+                bme280CalculateHumidity(&device, &data) != humidity[i]) {
+                mismatch++;
+            }
+        }
+    }
+    printf("{\"name\":\"bme280_batch\",\"variant\":\"verify\","
+           "\"samples\":%u,\"mismatch\":%u}\n",
+           verify_count, mismatch);
+    fflush(stdout);
+
+    // Finalize
+    free(raw_temperature);
+    free(raw_pressure);
+    free(raw_humidity);
+    free(temperature);
+    free(pressure);
+    free(humidity);
+    spiFinalize(spi_device);
+    return mismatch != 0;
+}
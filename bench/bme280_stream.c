@@ -0,0 +1,97 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "device/bme280.h"
+#include "device/bme280_stream.h"
+#include "interface/spi.h"
+#include "simulator/bme280_sim.h"
+#include "simulator/simulator.h"
+#include "utility/clock.h"
+
+static uint64_t const run_time = 1000000000;
+static uint64_t const poll_time = 1000000;
+
+static void streamReport(char const* variant, uint64_t samples,
+                         uint64_t duplicates, uint64_t missed,
+                         uint64_t transfers, uint64_t expected) {
+    printf("{\"name\":\"bme280_stream\",\"variant\":\"%s\",\"samples\":%llu,"
+           "\"expected\":%llu,\"duplicates\":%llu,\"missed\":%llu,"
+           "\"transfers\":%llu,\"transfers_per_sample\":%.3f}\n",
+           variant, (unsigned long long)samples,
+           (unsigned long long)expected, (unsigned long long)duplicates,
+           (unsigned long long)missed, (unsigned long long)transfers,
+           samples ? (double)transfers / samples : 0.0);
+    fflush(stdout);
+}
+
+int main(void) {
+    // Drive every channel with a sine so consecutive samples differ
+    struct simulator_sine_t temperature = {519888, 2000, 1};
+    struct simulator_sine_t pressure = {415148, 2000, 1};
+    struct simulator_sine_t humidity = {30000, 2000, 1};
+    struct bme280_sim_settings_t sim_settings = {
+        .temperature = {simulatorSine, &temperature},
+        .pressure = {simulatorSine, &pressure},
+        .humidity = {simulatorSine, &humidity},
+    };
+    struct bme280_sim_t sim;
+    bme280SimInitialize(&sim, &sim_settings);
+    struct spi_settings_t spi_settings = {
+        .backend = &bme280_sim_backend,
+        .backend_data = &sim,
+    };
+    spi_device_t spi_device = spiInitialize(&spi_settings);
+    struct bme280_t device;
+    bme280Initialize(&device, spi_device);
+    struct bme280_settings_t settings = {
+        .mode = bme280_mode_normal,
+        .osr_temp = bme280_osr_temp_x1,
+        .osr_pres = bme280_osr_pres_x1,
+        .osr_hum = bme280_osr_hum_x1,
+        .standby = bme280_standbytime_1s,
+        .filter = bme280_filter_off,
+    };
+
+    // Poll a free-running device fast enough not to miss anything
+    struct bme280_data_t data;
+    struct bme280_data_t last = {0};
+    uint64_t samples = 0;
+    uint64_t reads = 0;
+    bme280SetDeviceSettings(&device, &settings);
+    uint64_t start = clockGetTime();
+    while (clockGetTime() - start < run_time) {
+        bme280ReadDeviceData(&device, &data);
+        reads++;
+        if (memcmp(&data, &last, sizeof(data)) != 0) {
+            samples++;
+            last = data;
+        }
+        clockSleepUntil(clockGetTime() + poll_time);
+    }
+    streamReport("poll", samples, reads - samples, 0, reads,
+                 run_time / sim.cycle_time);
+
+    // Stream phase locked to the conversions, samples end on both the first
+    // and the last period boundary
+    struct bme280_stream_t stream;
+    struct bme280_stream_statistics_t statistics;
+    if (bme280StreamStart(&stream, &device, &settings) != 0) {
+        fprintf(stderr, "Failed to lock onto the conversion cadence\n");
+        return 1;
+    }
+    start = clockGetTime();
+    uint64_t transfers = stream.transfers;
+    while (clockGetTime() - start < run_time) {
+        bme280StreamRead(&stream, &data, NULL);
+    }
+    bme280StreamGetStatistics(&stream, &statistics);
+    uint64_t elapsed = clockGetTime() - stream.start_time;
+    streamReport("stream", statistics.samples, statistics.duplicates,
+                 statistics.missed, statistics.transfers - transfers,
+                 (elapsed + sim.cycle_time / 2) / sim.cycle_time + 1);
+    bme280StreamStop(&stream);
+
+    spiFinalize(spi_device);
+    return 0;
+}
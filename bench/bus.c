@@ -0,0 +1,154 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "device/bme280.h"
+#include "interface/bus.h"
+#include "interface/i2c.h"
+#include "interface/spi.h"
+#include "simulator/bme280_sim.h"
+#include "simulator/tsl2561_sim.h"
+#include "utility/clock.h"
+
+#define BUS_BATCH 64
+#define BUS_ROUNDS 256
+
+static uint32_t const bus_reads = 2000;
+static uint8_t const bus_bme280_id_addr = 0xD0;
+static uint8_t const bus_bme280_chip_id = 0x60;
+static uint8_t const bus_tsl2561_id_addr = 0x8A;
+static uint8_t const bus_tsl2561_part_id = 0x50;
+
+static atomic_uint bus_callbacks;
+
+static void busBenchComplete(struct bus_transaction_t* transaction) {
+    atomic_fetch_add_explicit((atomic_uint*)transaction->context, 1,
+                              memory_order_relaxed);
+}
+
+static double busBenchRead(struct bme280_t* device) {
+    struct bme280_data_t data;
+    uint64_t start = clockGetTime();
+    for (uint32_t i = 0; i < bus_reads; i++) {
+        bme280ReadDeviceData(device, &data);
+    }
+    return (double)(clockGetTime() - start) / bus_reads;
+}
+
+int main(void) {
+    struct bus_executor_t executor;
+    if (busInitialize(&executor) != 0) {
+        fprintf(stderr, "Failed to start the bus executor\n");
+        return 1;
+    }
+    struct bme280_sim_t bme280_sim;
+    bme280SimInitialize(&bme280_sim, NULL);
+    struct tsl2561_sim_t tsl2561_sim;
+    tsl2561SimInitialize(&tsl2561_sim, NULL);
+    struct bus_settings_t spi_bus_settings = {
+        .executor = &executor,
+        .spi_backend = &bme280_sim_backend,
+        .backend_data = &bme280_sim,
+    };
+    struct bus_settings_t i2c_bus_settings = {
+        .executor = &executor,
+        .i2c_backend = &tsl2561_sim_backend,
+        .backend_data = &tsl2561_sim,
+    };
+    struct spi_settings_t direct_settings = {
+        .backend = &bme280_sim_backend,
+        .backend_data = &bme280_sim,
+    };
+    struct spi_settings_t spi_settings = {
+        .backend = &bus_spi_backend,
+        .backend_data = &spi_bus_settings,
+    };
+    struct i2c_settings_t i2c_settings = {
+        .backend = &bus_i2c_backend,
+        .backend_data = &i2c_bus_settings,
+    };
+    spi_device_t direct_spi = spiInitialize(&direct_settings);
+    spi_device_t bus_spi = spiInitialize(&spi_settings);
+    i2c_device_t bus_i2c = i2cInitialize(&i2c_settings);
+
+    // The synchronous backend hands every transfer to the executor thread
+    struct bme280_settings_t bme280_settings = {
+        .mode = bme280_mode_normal,
+        .osr_temp = bme280_osr_temp_x1,
+        .osr_pres = bme280_osr_pres_x1,
+        .osr_hum = bme280_osr_hum_x1,
+        .standby = bme280_standbytime_1s,
+        .filter = bme280_filter_off,
+    };
+    struct bme280_t direct;
+    struct bme280_t bused;
+    bme280Initialize(&direct, direct_spi);
+    bme280SetDeviceSettings(&direct, &bme280_settings);
+    bme280Initialize(&bused, bus_spi);
+    bme280SetDeviceSettings(&bused, &bme280_settings);
+    double direct_ns = busBenchRead(&direct);
+    double bused_ns = busBenchRead(&bused);
+    printf("{\"name\":\"bus\",\"variant\":\"sync\",\"reads\":%u,"
+           "\"direct_ns_per_read\":%.1f,\"bus_ns_per_read\":%.1f}\n",
+           bus_reads, direct_ns, bused_ns);
+    fflush(stdout);
+
+    // Queue a batch of register reads and let the executor drain it
+    static struct bus_transaction_t transactions[BUS_BATCH];
+    static uint8_t tx_buffers[BUS_BATCH][2];
+    static uint8_t rx_buffers[BUS_BATCH][2];
+    uint64_t failed = 0;
+    uint64_t wrong = 0;
+    atomic_init(&bus_callbacks, 0);
+    uint64_t start = clockGetTime();
+    for (uint32_t round = 0; round < BUS_ROUNDS; round++) {
+        for (uint32_t i = 0; i < BUS_BATCH; i++) {
+            tx_buffers[i][0] = bus_bme280_id_addr;
+            tx_buffers[i][1] = 0;
+            rx_buffers[i][1] = 0;
+            if (busSpiTransfer(&transactions[i], bus_spi, tx_buffers[i],
+                               rx_buffers[i], 2, busBenchComplete,
+                               &bus_callbacks) != 0) {
+                failed++;
+            }
+        }
+        for (uint32_t i = 0; i < BUS_BATCH; i++) {
+            if (busWait(&transactions[i]) != 2) {
+                failed++;
+            }
+            wrong += rx_buffers[i][1] != bus_bme280_chip_id;
+        }
+    }
+    uint64_t elapsed = clockGetTime() - start;
+    printf("{\"name\":\"bus\",\"variant\":\"spi_async\",\"transfers\":%u,"
+           "\"ns_per_transfer\":%.1f,\"callbacks\":%u,\"failed\":%llu,"
+           "\"wrong\":%llu}\n",
+           BUS_BATCH * BUS_ROUNDS, (double)elapsed / (BUS_BATCH * BUS_ROUNDS),
+           atomic_load(&bus_callbacks), (unsigned long long)failed,
+           (unsigned long long)wrong);
+    fflush(stdout);
+
+    // Without a callback the transaction only completes through busWait
+    uint8_t tx_buffer[1] = {bus_tsl2561_id_addr};
+    uint8_t rx_buffer[1] = {0};
+    struct bus_transaction_t transaction;
+    int8_t submitted = busI2cWriteRead(&transaction, bus_i2c, tx_buffer, 1,
+                                       rx_buffer, 1, NULL, NULL);
+    int32_t result = submitted == 0 ? busWait(&transaction) : -1;
+    printf("{\"name\":\"bus\",\"variant\":\"i2c_async\",\"result\":%d,"
+           "\"part_id\":%u,\"expected_part_id\":%u}\n",
+           result, rx_buffer[0] & 0xF0, bus_tsl2561_part_id);
+    fflush(stdout);
+
+    // A device that was not opened through the bus has no executor
+    printf("{\"name\":\"bus\",\"variant\":\"reject\",\"result\":%d}\n",
+           busSpiTransfer(&transaction, direct_spi, tx_buffer, rx_buffer, 1,
+                          NULL, NULL));
+    fflush(stdout);
+
+    i2cFinalize(bus_i2c);
+    spiFinalize(bus_spi);
+    spiFinalize(direct_spi);
+    busFinalize(&executor);
+    return 0;
+}
@@ -0,0 +1,399 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+#include "interface/i2c.h"
+#include "interface/spi.h"
+#include "simulator/bme280_sim.h"
+#include "simulator/mcp3002_sim.h"
+#include "simulator/tsl2561_sim.h"
+#include "utility/clock.h"
+#include "utility/instrument.h"
+
+#ifdef BME280_FLOAT_ENABLE
+typedef double bme280_temperature_t;
+typedef double bme280_pressure_t;
+typedef double bme280_humidity_t;
+static char const bme280_variant[] = "float";
+#else
+typedef int32_t bme280_temperature_t;
+typedef uint32_t bme280_pressure_t;
+typedef uint32_t bme280_humidity_t;
+static char const bme280_variant[] = "fixed";
+#endif
+
+#ifdef TSL2561_FLOAT_ENABLE
+typedef double tsl2561_illuminance_t;
+static char const tsl2561_variant[] = "float";
+#else
+typedef uint32_t tsl2561_illuminance_t;
+static char const tsl2561_variant[] = "fixed";
+#endif
+
+#ifdef MCP3002_FLOAT_ENABLE
+typedef double mcp3002_voltage_t;
+static char const mcp3002_variant[] = "float";
+#else
+typedef uint32_t mcp3002_voltage_t;
+static char const mcp3002_variant[] = "fixed";
+#endif
+
+#define BENCH_CHUNK 256
+#define BENCH_ROUNDS 2048
+#define BENCH_READS 2000
+#define BENCH_BLOCKING_READS 40
+#define BENCH_ONESHOT_READS 8
+#define BENCH_INITIALIZES 20
+
+static uint32_t random_state = 0x2545F491;
+static volatile double sink;
+
+static uint32_t randomNext(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static int benchCompare(void const* a, void const* b) {
+    uint64_t x = *(uint64_t const*)a;
+    uint64_t y = *(uint64_t const*)b;
+    return (x > y) - (x < y);
+}
+
+static double benchPercentile(uint64_t* samples, uint32_t count,
+                              uint32_t percent) {
+    uint32_t rank = (count * percent + 99) / 100;
+    return (double)samples[rank ? rank - 1 : 0];
+}
+
+static void benchReport(char const* name, char const* variant,
+                        uint64_t* samples, uint32_t count,
+                        uint32_t ops_per_sample) {
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        total += samples[i];
+    }
+    qsort(samples, count, sizeof(uint64_t), benchCompare);
+    double ops = (double)count * ops_per_sample;
+    printf("{\"name\":\"%s\",\"variant\":\"%s\",\"ops\":%.0f,"
+           "\"ns_per_op\":%.3f,\"ops_per_s\":%.0f,\"p50_ns\":%.3f,"
+           "\"p90_ns\":%.3f,\"p99_ns\":%.3f,\"max_ns\":%.3f}\n",
+           name, variant, ops, total / ops, ops * 1e9 / total,
+           benchPercentile(samples, count, 50) / ops_per_sample,
+           benchPercentile(samples, count, 90) / ops_per_sample,
+           benchPercentile(samples, count, 99) / ops_per_sample,
+           (double)samples[count - 1] / ops_per_sample);
+    fflush(stdout);
+}
+
+static void benchBme280Compensate(struct bme280_t* device,
+                                  uint64_t* samples) {
+    struct bme280_data_t raw[BENCH_CHUNK];
+    uint32_t raw_temperature[BENCH_CHUNK];
+    uint32_t raw_pressure[BENCH_CHUNK];
+    uint32_t raw_humidity[BENCH_CHUNK];
+    bme280_temperature_t temperature[BENCH_CHUNK];
+    bme280_pressure_t pressure[BENCH_CHUNK];
+    bme280_humidity_t humidity[BENCH_CHUNK];
+    for (uint32_t i = 0; i < BENCH_CHUNK; i++) {
+        raw[i].temperature = 480000 + randomNext() % 80000;
+        raw[i].pressure = 380000 + randomNext() % 80000;
+        raw[i].humidity = 20000 + randomNext() % 20000;
+        raw_temperature[i] = raw[i].temperature;
+        raw_pressure[i] = raw[i].pressure;
+        raw_humidity[i] = raw[i].humidity;
+    }
+
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = clockGetTime();
+        for (uint32_t i = 0; i < BENCH_CHUNK; i++) {
+            temperature[i] = bme280CalculateTemperature(device, &raw[i]);
+            pressure[i] = bme280CalculatePressure(device, &raw[i]);
+            humidity[i] = bme280CalculateHumidity(device, &raw[i]);
+        }
+        samples[round] = clockGetTime() - start;
+        sink += temperature[round % BENCH_CHUNK];
+    }
+    benchReport("bme280_compensate", bme280_variant, samples, BENCH_ROUNDS,
+                BENCH_CHUNK);
+
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        struct bme280_measurement_t measurement;
+        uint64_t start = clockGetTime();
+        for (uint32_t i = 0; i < BENCH_CHUNK; i++) {
+            bme280Compensate(&device->compensation, &raw[i], &measurement);
+            pressure[i] = measurement.pressure;
+        }
+        samples[round] = clockGetTime() - start;
+        sink += pressure[round % BENCH_CHUNK];
+    }
+    benchReport("bme280_compensate_fused", bme280_variant, samples,
+                BENCH_ROUNDS, BENCH_CHUNK);
+
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = clockGetTime();
+        bme280CompensateBatch(device, raw_temperature, raw_pressure,
+                              raw_humidity, temperature, pressure, humidity,
+                              BENCH_CHUNK);
+        samples[round] = clockGetTime() - start;
+        sink += humidity[round % BENCH_CHUNK];
+    }
+    benchReport("bme280_compensate_batch", bme280_variant, samples,
+                BENCH_ROUNDS, BENCH_CHUNK);
+}
+
+static void benchBme280Decode(uint64_t* samples) {
+    uint8_t data_reg[BENCH_CHUNK][8];
+    struct bme280_data_t data[BENCH_CHUNK];
+    for (uint32_t i = 0; i < BENCH_CHUNK; i++) {
+        for (uint32_t j = 0; j < 8; j++) {
+            data_reg[i][j] = randomNext();
+        }
+    }
+
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = clockGetTime();
+        for (uint32_t i = 0; i < BENCH_CHUNK; i++) {
+            bme280DecodeDeviceData(data_reg[i], &data[i]);
+        }
+        samples[round] = clockGetTime() - start;
+        sink += data[round % BENCH_CHUNK].pressure;
+    }
+    benchReport("bme280_decode", "fixed", samples, BENCH_ROUNDS,
+                BENCH_CHUNK);
+}
+
+// Reads go through the public call end to end, conversion wait included
+static void benchBme280Read(struct bme280_t* device, uint64_t* samples) {
+    struct bme280_settings_t settings = {
+        .mode = bme280_mode_normal,
+        .osr_temp = bme280_osr_temp_x1,
+        .osr_pres = bme280_osr_pres_x1,
+        .osr_hum = bme280_osr_hum_x1,
+        .standby = bme280_standbytime_1s,
+        .filter = bme280_filter_off,
+    };
+    struct bme280_data_t data;
+    bme280SetDeviceSettings(device, &settings);
+
+    for (uint32_t i = 0; i < BENCH_READS; i++) {
+        uint64_t start = clockGetTime();
+        bme280ReadDeviceData(device, &data);
+        samples[i] = clockGetTime() - start;
+        sink += data.temperature;
+    }
+    benchReport("bme280_read_normal", "simulator", samples, BENCH_READS, 1);
+
+    settings.mode = bme280_mode_forced;
+    bme280SetDeviceSettings(device, &settings);
+    for (uint32_t i = 0; i < BENCH_BLOCKING_READS; i++) {
+        uint64_t start = clockGetTime();
+        bme280ReadDeviceData(device, &data);
+        samples[i] = clockGetTime() - start;
+        sink += data.temperature;
+    }
+    benchReport("bme280_read_forced", "simulator", samples,
+                BENCH_BLOCKING_READS, 1);
+}
+
+static void benchBme280Initialize(spi_device_t spi_device,
+                                  uint64_t* samples) {
+    struct bme280_cache_t cache;
+    struct bme280_t device;
+    bme280CacheInitialize(&cache);
+
+    for (uint32_t i = 0; i < BENCH_INITIALIZES; i++) {
+        uint64_t start = clockGetTime();
+        bme280Initialize(&device, spi_device);
+        samples[i] = clockGetTime() - start;
+    }
+    benchReport("bme280_initialize", "simulator", samples, BENCH_INITIALIZES,
+                1);
+
+    bme280InitializeCached(&device, spi_device, &cache);
+    for (uint32_t i = 0; i < BENCH_INITIALIZES; i++) {
+        uint64_t start = clockGetTime();
+        bme280InitializeCached(&device, spi_device, &cache);
+        samples[i] = clockGetTime() - start;
+    }
+    benchReport("bme280_initialize_cached", "simulator", samples,
+                BENCH_INITIALIZES, 1);
+}
+
+static void benchTsl2561Illuminance(struct tsl2561_t* device,
+                                    uint64_t* samples) {
+    struct tsl2561_data_t data[BENCH_CHUNK];
+    tsl2561_illuminance_t illuminance[BENCH_CHUNK];
+    for (uint32_t i = 0; i < BENCH_CHUNK; i++) {
+        data[i].channel_0 = randomNext() % 65536;
+        data[i].channel_1 = randomNext() % (data[i].channel_0 + 1);
+    }
+
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = clockGetTime();
+        for (uint32_t i = 0; i < BENCH_CHUNK; i++) {
+            illuminance[i] = tsl2561CalculateIlluminance(device, &data[i]);
+        }
+        samples[round] = clockGetTime() - start;
+        sink += illuminance[round % BENCH_CHUNK];
+    }
+    benchReport("tsl2561_illuminance", tsl2561_variant, samples,
+                BENCH_ROUNDS, BENCH_CHUNK);
+
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = clockGetTime();
+        tsl2561CalculateIlluminanceBatch(device, data, illuminance,
+                                         BENCH_CHUNK);
+        samples[round] = clockGetTime() - start;
+        sink += illuminance[round % BENCH_CHUNK];
+    }
+    benchReport("tsl2561_illuminance_batch", tsl2561_variant, samples,
+                BENCH_ROUNDS, BENCH_CHUNK);
+}
+
+static void benchTsl2561Read(struct tsl2561_t* device, uint64_t* samples) {
+    struct tsl2561_settings_t settings = {
+        .gain = tsl2561_gain_16x,
+        .integral = tsl2561_integral_13ms,
+        .mode = tsl2561_mode_continuous,
+    };
+    struct tsl2561_data_t data;
+    tsl2561SetDeviceSettings(device, &settings);
+
+    // Fetch alone, then the public read with its integration wait
+    for (uint32_t i = 0; i < BENCH_BLOCKING_READS; i++) {
+        clockSleepUntil(tsl2561GetReadyTime(device));
+        uint64_t start = clockGetTime();
+        tsl2561FetchDeviceData(device, &data);
+        samples[i] = clockGetTime() - start;
+        sink += data.channel_0;
+    }
+    benchReport("tsl2561_fetch", "simulator", samples, BENCH_BLOCKING_READS,
+                1);
+
+    for (uint32_t i = 0; i < BENCH_BLOCKING_READS; i++) {
+        uint64_t start = clockGetTime();
+        tsl2561ReadDeviceData(device, &data);
+        samples[i] = clockGetTime() - start;
+        sink += data.channel_0;
+    }
+    benchReport("tsl2561_read_continuous", "simulator", samples,
+                BENCH_BLOCKING_READS, 1);
+
+    settings.mode = tsl2561_mode_oneshot;
+    tsl2561SetDeviceSettings(device, &settings);
+    for (uint32_t i = 0; i < BENCH_ONESHOT_READS; i++) {
+        uint64_t start = clockGetTime();
+        tsl2561ReadDeviceData(device, &data);
+        samples[i] = clockGetTime() - start;
+        sink += data.channel_0;
+    }
+    benchReport("tsl2561_read_oneshot", "simulator", samples,
+                BENCH_ONESHOT_READS, 1);
+}
+
+static void benchMcp3002Voltage(struct mcp3002_t* device, uint64_t* samples) {
+    struct mcp3002_data_t data[BENCH_CHUNK];
+    mcp3002_voltage_t voltage[BENCH_CHUNK];
+    for (uint32_t i = 0; i < BENCH_CHUNK; i++) {
+        data[i].differential_0 = randomNext() % 1024;
+        data[i].differential_1 = randomNext() % 1024;
+        data[i].single_0 = randomNext() % 1024;
+        data[i].single_1 = randomNext() % 1024;
+    }
+
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = clockGetTime();
+        for (uint32_t i = 0; i < BENCH_CHUNK; i++) {
+            voltage[i] = mcp3002CalculateVoltage(device, &data[i],
+                                                 mcp3002_channel_single_0);
+        }
+        samples[round] = clockGetTime() - start;
+        sink += voltage[round % BENCH_CHUNK];
+    }
+    benchReport("mcp3002_voltage", mcp3002_variant, samples, BENCH_ROUNDS,
+                BENCH_CHUNK);
+}
+
+static void benchMcp3002Read(struct mcp3002_t* device, uint64_t* samples) {
+    struct mcp3002_data_t data;
+    for (uint32_t i = 0; i < BENCH_READS; i++) {
+        uint64_t start = clockGetTime();
+        mcp3002ReadDeviceData(device, &data);
+        samples[i] = clockGetTime() - start;
+        sink += data.single_0;
+    }
+    benchReport("mcp3002_read", "simulator", samples, BENCH_READS, 1);
+}
+
+int main(int argc, char** argv) {
+    char const* filter = argc > 1 ? argv[1] : "";
+    uint64_t* samples = malloc(BENCH_ROUNDS * sizeof(uint64_t));
+
+    // Initialize simulated devices
+    struct bme280_sim_t bme280_sim;
+    bme280SimInitialize(&bme280_sim, NULL);
+    struct spi_settings_t bme280_spi_settings = {
+        .backend = &bme280_sim_backend,
+        .backend_data = &bme280_sim,
+    };
+    spi_device_t bme280_spi = spiInitialize(&bme280_spi_settings);
+    struct bme280_t bme280;
+    bme280Initialize(&bme280, bme280_spi);
+
+    struct tsl2561_sim_t tsl2561_sim;
+    tsl2561SimInitialize(&tsl2561_sim, NULL);
+    struct i2c_settings_t tsl2561_i2c_settings = {
+        .backend = &tsl2561_sim_backend,
+        .backend_data = &tsl2561_sim,
+    };
+    i2c_device_t tsl2561_i2c = i2cInitialize(&tsl2561_i2c_settings);
+    struct tsl2561_t tsl2561;
+    tsl2561Initialize(&tsl2561, tsl2561_i2c);
+
+    struct mcp3002_sim_t mcp3002_sim;
+    mcp3002SimInitialize(&mcp3002_sim, NULL);
+    struct spi_settings_t mcp3002_spi_settings = {
+        .backend = &mcp3002_sim_backend,
+        .backend_data = &mcp3002_sim,
+    };
+    spi_device_t mcp3002_spi = spiInitialize(&mcp3002_spi_settings);
+    struct mcp3002_t mcp3002;
+    mcp3002Initialize(&mcp3002, mcp3002_spi);
+    struct mcp3002_settings_t mcp3002_settings = {
+        .base_voltage = 3300,
+    };
+    mcp3002SetDeviceSettings(&mcp3002, &mcp3002_settings);
+
+    // Run the benchmark groups selected by the optional prefix argument
+    if (strncmp("bme280", filter, strlen(filter)) == 0) {
+        benchBme280Compensate(&bme280, samples);
+        benchBme280Decode(samples);
+        benchBme280Read(&bme280, samples);
+        benchBme280Initialize(bme280_spi, samples);
+    }
+    if (strncmp("tsl2561", filter, strlen(filter)) == 0) {
+        benchTsl2561Illuminance(&tsl2561, samples);
+        benchTsl2561Read(&tsl2561, samples);
+    }
+    if (strncmp("mcp3002", filter, strlen(filter)) == 0) {
+        benchMcp3002Voltage(&mcp3002, samples);
+        benchMcp3002Read(&mcp3002, samples);
+    }
+
+#ifdef INSTRUMENT_ENABLE
+    instrumentDump(stderr);
+#endif
+
+    // Finalize
+    spiFinalize(bme280_spi);
+    i2cFinalize(tsl2561_i2c);
+    spiFinalize(mcp3002_spi);
+    free(samples);
+    return 0;
+}
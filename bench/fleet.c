@@ -0,0 +1,108 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#include "device/bme280.h"
+#include "device/tsl2561.h"
+#include "interface/i2c.h"
+#include "interface/spi.h"
+#include "simulator/bme280_sim.h"
+#include "simulator/tsl2561_sim.h"
+#include "utility/clock.h"
+#include "utility/fleet.h"
+
+#define FLEET_BME280_COUNT 12
+#define FLEET_TSL2561_COUNT 6
+#define FLEET_COUNT (FLEET_BME280_COUNT + FLEET_TSL2561_COUNT)
+
+static char const* const fleet_status_name[] = {
+    "timeout", "missing", "pending", "ready", "cached",
+};
+
+static void fleetReport(char const* variant, uint64_t time,
+                        struct fleet_device_t* devices) {
+    printf("{\"name\":\"fleet_initialize\",\"variant\":\"%s\",\"devices\":%u,"
+           "\"total_ns\":%llu",
+           variant, FLEET_COUNT, (unsigned long long)time);
+    if (devices != NULL) {
+        uint32_t status_count[5] = {0};
+        uint64_t slowest = 0;
+        for (uint32_t i = 0; i < FLEET_COUNT; i++) {
+            status_count[devices[i].status + 2]++;
+            if (devices[i].time > slowest) {
+                slowest = devices[i].time;
+            }
+        }
+        printf(",\"slowest_ns\":%llu", (unsigned long long)slowest);
+        for (uint32_t i = 0; i < 5; i++) {
+            printf(",\"%s\":%u", fleet_status_name[i], status_count[i]);
+        }
+    }
+    printf("}\n");
+    fflush(stdout);
+}
+
+int main(void) {
+    // Spread simulated devices over two SPI and two I2C buses
+    struct bme280_sim_t bme280_sim[FLEET_BME280_COUNT];
+    struct tsl2561_sim_t tsl2561_sim[FLEET_TSL2561_COUNT];
+    struct bme280_t bme280[FLEET_BME280_COUNT];
+    struct tsl2561_t tsl2561[FLEET_TSL2561_COUNT];
+    struct fleet_device_t devices[FLEET_COUNT];
+    for (uint32_t i = 0; i < FLEET_BME280_COUNT; i++) {
+        bme280SimInitialize(&bme280_sim[i], NULL);
+        struct spi_settings_t settings = {
+            .bus_number = i % 2,
+            .slave_number = i / 2,
+            .backend = &bme280_sim_backend,
+            .backend_data = &bme280_sim[i],
+        };
+        devices[i].type = fleet_device_bme280;
+        devices[i].device = &bme280[i];
+        devices[i].spi_device = spiInitialize(&settings);
+    }
+    for (uint32_t i = 0; i < FLEET_TSL2561_COUNT; i++) {
+        tsl2561SimInitialize(&tsl2561_sim[i], NULL);
+        struct i2c_settings_t settings = {
+            .bus_number = i % 2,
+            .address = 0x29 + i / 2,
+            .backend = &tsl2561_sim_backend,
+            .backend_data = &tsl2561_sim[i],
+        };
+        struct fleet_device_t* device = &devices[FLEET_BME280_COUNT + i];
+        device->type = fleet_device_tsl2561;
+        device->device = &tsl2561[i];
+        device->i2c_device = i2cInitialize(&settings);
+    }
+
+    // One device after another
+    uint64_t start = clockGetTime();
+    for (uint32_t i = 0; i < FLEET_BME280_COUNT; i++) {
+        bme280Initialize(&bme280[i], devices[i].spi_device);
+    }
+    for (uint32_t i = 0; i < FLEET_TSL2561_COUNT; i++) {
+        tsl2561Initialize(&tsl2561[i],
+                          devices[FLEET_BME280_COUNT + i].i2c_device);
+    }
+    fleetReport("serial", clockGetTime() - start, NULL);
+
+    // All devices at once, then again with a warm calibration cache
+    struct bme280_cache_t cache;
+    bme280CacheInitialize(&cache);
+    struct fleet_settings_t settings = {
+        .bme280_cache = &cache,
+    };
+    uint64_t time = fleetInitialize(devices, FLEET_COUNT, NULL);
+    fleetReport("fleet", time, devices);
+    fleetInitialize(devices, FLEET_COUNT, &settings);
+    time = fleetInitialize(devices, FLEET_COUNT, &settings);
+    fleetReport("fleet_cached", time, devices);
+
+    for (uint32_t i = 0; i < FLEET_COUNT; i++) {
+        if (devices[i].type == fleet_device_bme280) {
+            spiFinalize(devices[i].spi_device);
+        } else {
+            i2cFinalize(devices[i].i2c_device);
+        }
+    }
+    return 0;
+}
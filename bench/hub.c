@@ -0,0 +1,152 @@
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "interface/spi.h"
+#include "simulator/bme280_sim.h"
+#include "simulator/mcp3002_sim.h"
+#include "utility/clock.h"
+#include "utility/hub.h"
+#include "utility/hub_client.h"
+#include "utility/scheduler.h"
+
+#define HUB_CLIENTS 5
+
+struct hub_bench_client_t {
+    uint32_t device_id;
+    uint64_t period;
+    uint32_t batch;
+};
+
+static char const* const hub_path = "/tmp/hub_bench.sock";
+static unsigned const run_time = 2;
+
+// Overlapping subscriptions, the hub should only sample at the fastest rate
+static struct hub_bench_client_t const hub_clients[HUB_CLIENTS] = {
+    {0, 1000000, 32},
+    {0, 2000000, 16},
+    {0, 5000000, 8},
+    {1, 50000000, 1},
+    {1, 100000000, 1},
+};
+
+static struct scheduler_t scheduler;
+
+static void hubBenchStop(int signal_number) {
+    (void)signal_number;
+    schedulerStop(&scheduler);
+}
+
+static void hubBenchClient(uint32_t index) {
+    struct hub_bench_client_t const* settings = &hub_clients[index];
+    struct hub_client_t client;
+    struct sample_t samples[HUB_BATCH_MAX];
+    if (hubClientOpen(&client, hub_path) != 0 ||
+        hubClientSubscribe(&client, settings->device_id, settings->period,
+                           settings->batch) != 0) {
+        fprintf(stderr, "Failed to subscribe client %u\n", index);
+        _exit(1);
+    }
+    uint64_t received = 0;
+    uint64_t frames = 0;
+    uint64_t first = 0;
+    uint64_t last = 0;
+    int32_t count;
+    while ((count = hubClientRead(&client, samples, HUB_BATCH_MAX)) > 0) {
+        if (received == 0) {
+            first = samples[0].timestamp;
+        }
+        last = samples[count - 1].timestamp;
+        received += count;
+        frames++;
+    }
+    double period = received > 1 ? (double)(last - first) / (received - 1)
+                                 : 0.0;
+    printf("{\"name\":\"hub\",\"variant\":\"client\",\"index\":%u,"
+           "\"device_id\":%u,\"requested_period_ns\":%llu,"
+           "\"period_ns\":%.0f,\"samples\":%llu,\"frames\":%llu}\n",
+           index, settings->device_id,
+           (unsigned long long)settings->period, period,
+           (unsigned long long)received, (unsigned long long)frames);
+    fflush(stdout);
+    hubClientClose(&client);
+    _exit(0);
+}
+
+int main(void) {
+    struct bme280_sim_t bme280_sim;
+    bme280SimInitialize(&bme280_sim, NULL);
+    struct mcp3002_sim_t mcp3002_sim;
+    mcp3002SimInitialize(&mcp3002_sim, NULL);
+    struct spi_settings_t bme280_spi_settings = {
+        .backend = &bme280_sim_backend,
+        .backend_data = &bme280_sim,
+    };
+    struct spi_settings_t mcp3002_spi_settings = {
+        .backend = &mcp3002_sim_backend,
+        .backend_data = &mcp3002_sim,
+    };
+    spi_device_t bme280_spi = spiInitialize(&bme280_spi_settings);
+    spi_device_t mcp3002_spi = spiInitialize(&mcp3002_spi_settings);
+    struct bme280_t bme280;
+    bme280Initialize(&bme280, bme280_spi);
+    struct bme280_settings_t bme280_settings = {
+        .mode = bme280_mode_forced,
+        .osr_temp = bme280_osr_temp_x1,
+        .osr_pres = bme280_osr_pres_x1,
+        .osr_hum = bme280_osr_hum_x1,
+        .standby = bme280_standbytime_1s,
+        .filter = bme280_filter_off,
+    };
+    bme280SetDeviceSettings(&bme280, &bme280_settings);
+    struct mcp3002_t mcp3002;
+    mcp3002Initialize(&mcp3002, mcp3002_spi);
+
+    static struct hub_t hub;
+    if (schedulerInitialize(&scheduler) != 0 ||
+        hubInitialize(&hub, &scheduler, hub_path) != 0) {
+        fprintf(stderr, "Failed to listen on %s\n", hub_path);
+        return 1;
+    }
+    hubAddMcp3002(&hub, 0, &mcp3002);
+    hubAddBme280(&hub, 1, &bme280);
+
+    pid_t clients[HUB_CLIENTS];
+    for (uint32_t i = 0; i < HUB_CLIENTS; i++) {
+        clients[i] = fork();
+        if (clients[i] == 0) {
+            hubBenchClient(i);
+        }
+    }
+    signal(SIGALRM, hubBenchStop);
+    alarm(run_time);
+    schedulerRun(&scheduler);
+
+    // Closing the hub ends every client's stream
+    uint64_t dropped = 0;
+    for (uint32_t i = 0; i < HUB_CONNECTION_MAX; i++) {
+        dropped += hub.connections[i].dropped;
+    }
+    hubFinalize(&hub);
+    for (uint32_t i = 0; i < HUB_CLIENTS; i++) {
+        waitpid(clients[i], NULL, 0);
+    }
+    for (uint32_t i = 0; i < hub.device_count; i++) {
+        struct scheduler_statistics_t statistics;
+        schedulerGetStatistics(&hub.devices[i].task, &statistics);
+        printf("{\"name\":\"hub\",\"variant\":\"device\",\"device_id\":%u,"
+               "\"reads\":%llu,\"period_ns\":%.0f}\n",
+               hub.devices[i].device_id,
+               (unsigned long long)statistics.count, statistics.period);
+    }
+    printf("{\"name\":\"hub\",\"variant\":\"hub\",\"dropped\":%llu}\n",
+           (unsigned long long)dropped);
+    schedulerFinalize(&scheduler);
+    spiFinalize(bme280_spi);
+    spiFinalize(mcp3002_spi);
+    return 0;
+}
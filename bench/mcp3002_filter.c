@@ -0,0 +1,187 @@
+#include <linux/perf_event.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "device/mcp3002.h"
+#include "device/mcp3002_filter.h"
+#include "interface/spi.h"
+#include "simulator/mcp3002_sim.h"
+#include "utility/clock.h"
+
+#define FILTER_SAMPLES (1 << 20)
+#define FILTER_TAPS 31
+#define FILTER_DEVICE_SAMPLES 16384
+
+static double const sample_rate = 50000.0;
+static double const signal_frequency = 50.0;
+static double const interferer_frequency = 8000.0;
+
+static int filterOpenCycleCounter(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Windowed sinc low pass with unity gain at DC, in Q15
+static void filterDesignFir(int16_t* taps, double cutoff) {
+    double coefficient[FILTER_TAPS];
+    double sum = 0.0;
+    for (int32_t i = 0; i < FILTER_TAPS; i++) {
+        double n = i - (FILTER_TAPS - 1) / 2.0;
+        double sinc = n == 0.0 ? 2.0 * cutoff
+                               : sin(2.0 * M_PI * cutoff * n) / (M_PI * n);
+        double window = 0.54 - 0.46 * cos(2.0 * M_PI * i / (FILTER_TAPS - 1));
+        coefficient[i] = sinc * window;
+        sum += coefficient[i];
+    }
+    for (int32_t i = 0; i < FILTER_TAPS; i++) {
+        taps[i] = (int16_t)lround(coefficient[i] / sum * 32768.0);
+    }
+}
+
+// Butterworth low pass section, b0 b1 b2 a1 a2 in Q14
+static void filterDesignBiquad(int32_t* coefficients, double cutoff) {
+    double omega = 2.0 * M_PI * cutoff;
+    double alpha = sin(omega) / (2.0 * M_SQRT1_2);
+    double a0 = 1.0 + alpha;
+    double b = (1.0 - cos(omega)) / 2.0;
+    double scale = 1 << MCP3002_FILTER_BIQUAD_SHIFT;
+    coefficients[0] = (int32_t)lround(b / a0 * scale);
+    coefficients[1] = (int32_t)lround(2.0 * b / a0 * scale);
+    coefficients[2] = coefficients[0];
+    coefficients[3] = (int32_t)lround(-2.0 * cos(omega) / a0 * scale);
+    coefficients[4] = (int32_t)lround((1.0 - alpha) / a0 * scale);
+}
+
+static void filterBuild(struct mcp3002_filter_t* filter) {
+    int16_t taps[FILTER_TAPS];
+    int32_t coefficients[5];
+    filterDesignFir(taps, 0.1);
+    filterDesignBiquad(coefficients, 0.1);
+    mcp3002FilterInitialize(filter);
+    mcp3002FilterAddCic(filter, 3, 16);
+    mcp3002FilterAddFir(filter, taps, FILTER_TAPS, 4);
+    mcp3002FilterAddBiquad(filter, coefficients);
+}
+
+static double filterDeviation(uint16_t const* codes, uint32_t start,
+                              uint32_t count) {
+    double sum = 0.0;
+    double square = 0.0;
+    for (uint32_t i = start; i < count; i++) {
+        sum += codes[i];
+        square += (double)codes[i] * codes[i];
+    }
+    double mean = sum / (count - start);
+    return sqrt(square / (count - start) - mean * mean);
+}
+
+int main(void) {
+    // A slow signal buried under an interferer and a few codes of noise
+    uint16_t* codes = malloc(FILTER_SAMPLES * sizeof(uint16_t));
+    uint16_t* clean = malloc(FILTER_SAMPLES * sizeof(uint16_t));
+    uint16_t* output = malloc(FILTER_SAMPLES * sizeof(uint16_t));
+    srand(1);
+    for (uint32_t i = 0; i < FILTER_SAMPLES; i++) {
+        double time = i / sample_rate;
+        double interferer = 100.0 * sin(2.0 * M_PI * interferer_frequency *
+                                        time);
+        codes[i] = (uint16_t)lround(512.0 + interferer + rand() % 17 - 8);
+        clean[i] = (uint16_t)lround(
+            512.0 + 200.0 * sin(2.0 * M_PI * signal_frequency * time));
+    }
+
+    struct mcp3002_filter_t filter;
+    struct mcp3002_filter_statistics_t statistics;
+    filterBuild(&filter);
+    int cycle_fd = filterOpenCycleCounter();
+    uint64_t cycles = 0;
+    if (cycle_fd >= 0) {
+        ioctl(cycle_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(cycle_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    uint32_t produced = 0;
+    for (uint32_t i = 0; i < FILTER_SAMPLES; i += 4096) {
+        produced += mcp3002FilterProcess(&filter, &codes[i], 4096,
+                                         &output[produced]);
+    }
+    if (cycle_fd >= 0) {
+        ioctl(cycle_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(cycle_fd, &cycles, sizeof(cycles)) != sizeof(cycles)) {
+            cycles = 0;
+        }
+    }
+    mcp3002FilterGetStatistics(&filter, &statistics);
+    printf("{\"name\":\"mcp3002_filter\",\"variant\":\"noise\","
+           "\"samples_in\":%llu,\"samples_out\":%llu,\"ratio\":%u,"
+           "\"ns_per_sample\":%.2f,\"cycles_per_sample\":%.2f,"
+           "\"input_deviation\":%.2f,\"output_deviation\":%.3f}\n",
+           (unsigned long long)statistics.samples_in,
+           (unsigned long long)statistics.samples_out, statistics.ratio,
+           statistics.ns_per_sample,
+           cycle_fd >= 0 ? (double)cycles / statistics.samples_in : -1.0,
+           filterDeviation(codes, 0, FILTER_SAMPLES),
+           filterDeviation(output, 64, produced));
+    fflush(stdout);
+
+    // The passband signal comes through at the decimated rate
+    filterBuild(&filter);
+    produced = mcp3002FilterProcess(&filter, clean, FILTER_SAMPLES, output);
+    printf("{\"name\":\"mcp3002_filter\",\"variant\":\"passband\","
+           "\"input_deviation\":%.2f,\"output_deviation\":%.2f}\n",
+           filterDeviation(clean, 0, FILTER_SAMPLES),
+           filterDeviation(output, 64, produced));
+    fflush(stdout);
+
+    // Acquire from a device, filter, then convert only what is left
+    struct mcp3002_sim_t sim;
+    mcp3002SimInitialize(&sim, NULL);
+    struct spi_settings_t spi_settings = {
+        .backend = &mcp3002_sim_backend,
+        .backend_data = &sim,
+    };
+    spi_device_t spi_device = spiInitialize(&spi_settings);
+    struct mcp3002_t device;
+    mcp3002Initialize(&device, spi_device);
+    struct mcp3002_settings_t settings = {
+        .base_voltage = 3300,
+    };
+    mcp3002SetDeviceSettings(&device, &settings);
+    mcp3002ReadChannels(&device, mcp3002_channel_mask_single_0,
+                        FILTER_DEVICE_SAMPLES, codes);
+    filterBuild(&filter);
+    produced =
+        mcp3002FilterProcess(&filter, codes, FILTER_DEVICE_SAMPLES, output);
+    double voltage = 0.0;
+    for (uint32_t i = 0; i < produced; i++) {
+        struct mcp3002_data_t data = {.single_0 = output[i]};
+        voltage +=
+            mcp3002CalculateVoltage(&device, &data, mcp3002_channel_single_0);
+    }
+    printf("{\"name\":\"mcp3002_filter\",\"variant\":\"device\","
+           "\"samples_in\":%u,\"conversions\":%u,\"mean_voltage\":%.1f}\n",
+           FILTER_DEVICE_SAMPLES, produced,
+           produced ? voltage / produced : 0.0);
+    fflush(stdout);
+
+    spiFinalize(spi_device);
+    if (cycle_fd >= 0) {
+        close(cycle_fd);
+    }
+    free(codes);
+    free(clean);
+    free(output);
+    return 0;
+}
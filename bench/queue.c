@@ -0,0 +1,124 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "utility/clock.h"
+#include "utility/queue.h"
+#include "utility/sample.h"
+
+#define QUEUE_PRODUCERS 4
+#define QUEUE_BATCH 16
+
+static uint32_t const queue_capacity = 1024;
+static uint64_t const queue_samples = 1 << 21;
+
+struct queue_bench_producer_t {
+    struct mpsc_queue_t* queue;
+    uint32_t device_id;
+    uint64_t full;
+};
+
+static atomic_uint queue_ready;
+static atomic_uint queue_done;
+
+// Each producer numbers its samples so the consumer can spot gaps and repeats
+static void* queueBenchProduce(void* argument) {
+    struct queue_bench_producer_t* producer = argument;
+    struct sample_t samples[QUEUE_BATCH];
+    uint64_t next = 0;
+    atomic_fetch_add(&queue_ready, 1);
+    while (atomic_load(&queue_ready) < QUEUE_PRODUCERS + 1) {
+        sched_yield();
+    }
+    while (next < queue_samples) {
+        uint32_t count = queue_samples - next < QUEUE_BATCH
+                             ? (uint32_t)(queue_samples - next)
+                             : QUEUE_BATCH;
+        for (uint32_t i = 0; i < count; i++) {
+            samples[i].timestamp = next + i;
+            samples[i].device_id = producer->device_id;
+            samples[i].type = sample_type_mcp3002;
+        }
+        uint32_t pushed = mpscQueuePush(producer->queue, samples, count);
+        if (pushed == 0) {
+            producer->full++;
+            sched_yield();
+        }
+        next += pushed;
+    }
+    atomic_fetch_add(&queue_done, 1);
+    return NULL;
+}
+
+static void queueBenchMpsc(void) {
+    struct mpsc_queue_t queue;
+    if (mpscQueueInitialize(&queue, queue_capacity) != 0) {
+        fprintf(stderr, "Failed to allocate the queue\n");
+        return;
+    }
+    struct queue_bench_producer_t producers[QUEUE_PRODUCERS];
+    pthread_t threads[QUEUE_PRODUCERS];
+    atomic_init(&queue_ready, 0);
+    atomic_init(&queue_done, 0);
+    for (uint32_t i = 0; i < QUEUE_PRODUCERS; i++) {
+        producers[i].queue = &queue;
+        producers[i].device_id = i;
+        producers[i].full = 0;
+        pthread_create(&threads[i], NULL, queueBenchProduce, &producers[i]);
+    }
+    while (atomic_load(&queue_ready) < QUEUE_PRODUCERS) {
+        sched_yield();
+    }
+
+    struct sample_t samples[QUEUE_BATCH];
+    uint64_t expected[QUEUE_PRODUCERS] = {0};
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    uint64_t duplicated = 0;
+    uint64_t start = clockGetTime();
+    atomic_fetch_add(&queue_ready, 1);
+    for (;;) {
+        // Producers finish before they are counted, so one more pop drains
+        uint32_t done = atomic_load(&queue_done);
+        uint32_t count = mpscQueuePop(&queue, samples, QUEUE_BATCH);
+        if (count == 0) {
+            if (done == QUEUE_PRODUCERS) {
+                break;
+            }
+            sched_yield();
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t device_id = samples[i].device_id;
+            uint64_t sequence = samples[i].timestamp;
+            if (sequence < expected[device_id]) {
+                duplicated++;
+                continue;
+            }
+            lost += sequence - expected[device_id];
+            expected[device_id] = sequence + 1;
+        }
+        received += count;
+    }
+    uint64_t elapsed = clockGetTime() - start;
+    uint64_t full = 0;
+    for (uint32_t i = 0; i < QUEUE_PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+        full += producers[i].full;
+        lost += queue_samples - expected[i];
+    }
+    printf("{\"name\":\"queue\",\"variant\":\"mpsc\",\"producers\":%u,"
+           "\"samples\":%llu,\"ns_per_sample\":%.2f,\"full\":%llu,"
+           "\"lost\":%llu,\"duplicated\":%llu}\n",
+           QUEUE_PRODUCERS, (unsigned long long)received,
+           (double)elapsed / received, (unsigned long long)full,
+           (unsigned long long)lost, (unsigned long long)duplicated);
+    fflush(stdout);
+    mpscQueueFinalize(&queue);
+}
+
+int main(void) {
+    queueBenchMpsc();
+    return 0;
+}
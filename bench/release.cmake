@@ -0,0 +1,4 @@
+if(NOT BUILD_TYPE STREQUAL "Release")
+    message(FATAL_ERROR "bench needs a Release build, configure with "
+                        "-DCMAKE_BUILD_TYPE=Release")
+endif()
@@ -0,0 +1,175 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "device/bme280.h"
+#include "interface/spi.h"
+#include "simulator/bme280_sim.h"
+#include "utility/clock.h"
+#include "utility/sample.h"
+#include "utility/sample_log.h"
+
+#define SAMPLE_LOG_SAMPLES 1000000
+
+static uint64_t const sample_period = 10000000;
+static uint64_t const sample_jitter = 50000;
+
+static void sampleLogReport(char const* variant, uint64_t samples,
+                            uint64_t bytes, uint64_t time,
+                            uint64_t mismatches) {
+    printf("{\"name\":\"sample_log\",\"variant\":\"%s\",\"samples\":%llu,"
+           "\"bytes_per_sample\":%.3f,\"ns_per_sample\":%.2f,"
+           "\"mismatches\":%llu}\n",
+           variant, (unsigned long long)samples,
+           samples ? (double)bytes / samples : 0.0,
+           samples ? (double)time / samples : 0.0,
+           (unsigned long long)mismatches);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    char const* path = argc > 1 ? argv[1] : "sample_log_bench.slog";
+
+    // Calibration comes from a simulated device, the samples are synthetic
+    struct bme280_sim_t sim;
+    bme280SimInitialize(&sim, NULL);
+    struct spi_settings_t spi_settings = {
+        .backend = &bme280_sim_backend,
+        .backend_data = &sim,
+    };
+    spi_device_t spi_device = spiInitialize(&spi_settings);
+    struct bme280_t device;
+    bme280Initialize(&device, spi_device);
+    spiFinalize(spi_device);
+
+    struct sample_t* samples = malloc(SAMPLE_LOG_SAMPLES * sizeof(*samples));
+    uint64_t time = 1000000000;
+    srand(1);
+    for (uint32_t i = 0; i < SAMPLE_LOG_SAMPLES; i++) {
+        double phase = i * 2.0 * M_PI / 6000.0;
+        time += sample_period + rand() % (2 * sample_jitter) - sample_jitter;
+        samples[i].timestamp = time;
+        samples[i].device_id = 1;
+        samples[i].type = sample_type_bme280;
+        samples[i].data.bme280.temperature =
+            519888 + (int32_t)(2000 * sin(phase)) + rand() % 16;
+        samples[i].data.bme280.pressure =
+            415148 + (int32_t)(500 * cos(phase)) + rand() % 16;
+        samples[i].data.bme280.humidity =
+            30000 + (int32_t)(300 * sin(phase / 3)) + rand() % 4;
+    }
+
+    // Format the same samples as CSV lines for comparison
+    char line[64];
+    uint64_t text_size = 0;
+    uint64_t start = clockGetTime();
+    for (uint32_t i = 0; i < SAMPLE_LOG_SAMPLES; i++) {
+        text_size += snprintf(line, sizeof(line), "%llu,%u,%u,%u\n",
+                              (unsigned long long)samples[i].timestamp,
+                              samples[i].data.bme280.temperature,
+                              samples[i].data.bme280.pressure,
+                              samples[i].data.bme280.humidity);
+    }
+    uint64_t text_time = clockGetTime() - start;
+    sampleLogReport("text", SAMPLE_LOG_SAMPLES, text_size, text_time, 0);
+
+    // Append in small batches the way a queue consumer would
+    struct sample_log_header_t header;
+    struct sample_log_writer_t writer;
+    sampleLogHeaderFromBme280(&header, 1, &device);
+    if (sampleLogWriterOpen(&writer, path, &header) != 0) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+    start = clockGetTime();
+    for (uint32_t i = 0; i < SAMPLE_LOG_SAMPLES; i += 16) {
+        sampleLogWriterAppend(&writer, &samples[i], 16);
+    }
+    sampleLogWriterClose(&writer);
+    uint64_t write_time = clockGetTime() - start;
+
+    struct sample_log_reader_t reader;
+    if (sampleLogReaderOpen(&reader, path) != 0) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return 1;
+    }
+    sampleLogReport("write", reader.sample_count, reader.size, write_time, 0);
+
+    // Decode every block straight into columns and check them
+    static uint64_t timestamp[SAMPLE_LOG_BLOCK_SAMPLES];
+    static uint32_t field[3][SAMPLE_LOG_BLOCK_SAMPLES];
+    struct sample_log_columns_t columns = {
+        .timestamp = timestamp,
+        .field = {field[0], field[1], field[2]},
+    };
+    uint64_t mismatches = 0;
+    uint64_t decode_time = 0;
+    uint64_t index = 0;
+    for (uint32_t block = 0; block < reader.block_count; block++) {
+        start = clockGetTime();
+        uint32_t count = sampleLogReaderDecode(&reader, block, &columns);
+        decode_time += clockGetTime() - start;
+        for (uint32_t i = 0; i < count; i++, index++) {
+            struct sample_t* sample = &samples[index];
+            mismatches += timestamp[i] != sample->timestamp ||
+                          field[0][i] != sample->data.bme280.temperature ||
+                          field[1][i] != sample->data.bme280.pressure ||
+                          field[2][i] != sample->data.bme280.humidity;
+        }
+    }
+    mismatches += index != SAMPLE_LOG_SAMPLES;
+    sampleLogReport("decode", index, reader.size, decode_time, mismatches);
+
+    // Compensate from the stored calibration alone
+    struct bme280_t stored;
+    sampleLogHeaderToBme280(&reader.header, &stored);
+#ifdef BME280_FLOAT_ENABLE
+    static double temperature[SAMPLE_LOG_BLOCK_SAMPLES];
+    static double pressure[SAMPLE_LOG_BLOCK_SAMPLES];
+    static double humidity[SAMPLE_LOG_BLOCK_SAMPLES];
+#else
+    static int32_t temperature[SAMPLE_LOG_BLOCK_SAMPLES];
+    static uint32_t pressure[SAMPLE_LOG_BLOCK_SAMPLES];
+    static uint32_t humidity[SAMPLE_LOG_BLOCK_SAMPLES];
+#endif
+    mismatches = 0;
+    start = clockGetTime();
+    for (uint32_t block = 0; block < reader.block_count; block++) {
+        uint32_t count = sampleLogReaderDecode(&reader, block, &columns);
+        bme280CompensateBatch(&stored, field[0], field[1], field[2],
+                              temperature, pressure, humidity, count);
+    }
+    uint64_t compensate_time = clockGetTime() - start;
+    struct bme280_data_t last = samples[SAMPLE_LOG_SAMPLES - 1].data.bme280;
+    uint32_t last_index = (SAMPLE_LOG_SAMPLES - 1) % SAMPLE_LOG_BLOCK_SAMPLES;
+    mismatches += temperature[last_index] !=
+                  bme280CalculateTemperature(&device, &last);
+    mismatches += pressure[last_index] !=
+                  bme280CalculatePressure(&device, &last);
+    mismatches += humidity[last_index] !=
+                  bme280CalculateHumidity(&device, &last);
+    sampleLogReport("decode_compensate", reader.sample_count, reader.size,
+                    compensate_time, mismatches);
+
+    // Seek to the middle of the log and decode only the timestamp column
+    uint64_t target = samples[SAMPLE_LOG_SAMPLES / 2].timestamp;
+    columns.field[0] = columns.field[1] = columns.field[2] = NULL;
+    start = clockGetTime();
+    uint32_t block = sampleLogReaderSeek(&reader, target);
+    uint32_t count = sampleLogReaderDecode(&reader, block, &columns);
+    uint64_t seek_time = clockGetTime() - start;
+    mismatches = 1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (timestamp[i] == target) {
+            mismatches = 0;
+        }
+    }
+    sampleLogReport("seek", count, 0, seek_time, mismatches);
+
+    sampleLogReaderClose(&reader);
+    remove(path);
+    free(samples);
+    return 0;
+}
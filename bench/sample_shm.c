@@ -0,0 +1,113 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "utility/clock.h"
+#include "utility/sample.h"
+#include "utility/sample_shm.h"
+
+#define SHM_READERS 3
+#define SHM_DEVICES 8
+#define SHM_BATCH 8
+
+static char const* const shm_name = "/sample_shm_bench";
+static uint64_t const run_time = 1000000000;
+static uint64_t const publish_period = 100000;
+
+// Every field is derived from the timestamp so torn copies show up
+static uint8_t shmSampleValid(struct sample_t const* sample) {
+    uint32_t value = (uint32_t)sample->timestamp;
+    return sample->data.bme280.temperature == value &&
+           sample->data.bme280.pressure == ~value &&
+           sample->data.bme280.humidity == (value ^ sample->device_id);
+}
+
+static void shmReaderRun(uint32_t index) {
+    struct sample_shm_reader_t reader;
+    if (sampleShmReaderOpen(&reader, shm_name) != 0) {
+        fprintf(stderr, "Failed to attach to %s\n", shm_name);
+        _exit(1);
+    }
+    struct sample_t samples[64];
+    uint64_t history = 0;
+    uint64_t latest = 0;
+    uint64_t latest_time = 0;
+    uint64_t torn = 0;
+    uint64_t start = clockGetTime();
+    while (clockGetTime() - start < run_time) {
+        // Hammer the latest slots while the publisher is writing them
+        for (uint32_t i = 0; i < SHM_DEVICES; i++) {
+            struct sample_t sample;
+            uint64_t time = clockGetTime();
+            if (sampleShmReaderGetLatest(&reader, i, &sample) == 0) {
+                latest_time += clockGetTime() - time;
+                latest++;
+                torn += !shmSampleValid(&sample);
+            }
+        }
+        uint32_t count = sampleShmReaderRead(&reader, samples, 64);
+        for (uint32_t i = 0; i < count; i++) {
+            torn += !shmSampleValid(&samples[i]);
+        }
+        history += count;
+    }
+    printf("{\"name\":\"sample_shm\",\"variant\":\"reader\",\"index\":%u,"
+           "\"latest_reads\":%llu,\"latest_ns\":%.1f,\"history\":%llu,"
+           "\"lost\":%llu,\"torn\":%llu}\n",
+           index, (unsigned long long)latest,
+           latest ? (double)latest_time / latest : 0.0,
+           (unsigned long long)history, (unsigned long long)reader.lost,
+           (unsigned long long)torn);
+    fflush(stdout);
+    sampleShmReaderClose(&reader);
+    _exit(0);
+}
+
+int main(void) {
+    struct sample_shm_publisher_t publisher;
+    if (sampleShmPublisherOpen(&publisher, shm_name, 4096) != 0) {
+        fprintf(stderr, "Failed to create %s\n", shm_name);
+        return 1;
+    }
+    pid_t readers[SHM_READERS];
+    for (uint32_t i = 0; i < SHM_READERS; i++) {
+        readers[i] = fork();
+        if (readers[i] == 0) {
+            shmReaderRun(i);
+        }
+    }
+
+    // Publish batches the way one sampling loop would for the whole fleet
+    uint64_t published = 0;
+    uint64_t publish_time = 0;
+    uint64_t start = clockGetTime();
+    uint64_t next = start;
+    while (next - start < run_time + publish_period * 10) {
+        struct sample_t samples[SHM_BATCH];
+        uint64_t now = clockGetTime();
+        for (uint32_t i = 0; i < SHM_BATCH; i++) {
+            uint32_t value = (uint32_t)(now + i);
+            samples[i].timestamp = now + i;
+            samples[i].device_id = (published + i) % SHM_DEVICES;
+            samples[i].type = sample_type_bme280;
+            samples[i].data.bme280.temperature = value;
+            samples[i].data.bme280.pressure = ~value;
+            samples[i].data.bme280.humidity = value ^ samples[i].device_id;
+        }
+        sampleShmPublish(&publisher, samples, SHM_BATCH);
+        publish_time += clockGetTime() - now;
+        published += SHM_BATCH;
+        next += publish_period;
+        clockSleepUntil(next);
+    }
+    for (uint32_t i = 0; i < SHM_READERS; i++) {
+        waitpid(readers[i], NULL, 0);
+    }
+    printf("{\"name\":\"sample_shm\",\"variant\":\"publisher\","
+           "\"published\":%llu,\"publish_ns_per_sample\":%.1f}\n",
+           (unsigned long long)published, (double)publish_time / published);
+    sampleShmPublisherClose(&publisher);
+    sampleShmRemove(shm_name);
+    return 0;
+}
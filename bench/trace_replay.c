@@ -0,0 +1,152 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+#include "interface/i2c.h"
+#include "interface/spi.h"
+#include "interface/trace.h"
+#include "simulator/bme280_sim.h"
+#include "simulator/mcp3002_sim.h"
+#include "simulator/tsl2561_sim.h"
+#include "utility/clock.h"
+
+#define TRACE_READS 20000
+
+struct trace_session_t {
+    struct spi_settings_t bme280_spi_settings;
+    struct i2c_settings_t tsl2561_i2c_settings;
+    struct spi_settings_t mcp3002_spi_settings;
+    uint64_t checksum;
+    uint64_t time;
+};
+
+static void traceSessionRun(struct trace_session_t* session) {
+    uint64_t checksum = 0;
+    spi_device_t bme280_spi = spiInitialize(&session->bme280_spi_settings);
+    struct bme280_t bme280;
+    bme280Initialize(&bme280, bme280_spi);
+    struct bme280_settings_t bme280_settings = {
+        .mode = bme280_mode_normal,
+        .osr_temp = bme280_osr_temp_x1,
+        .osr_pres = bme280_osr_pres_x1,
+        .osr_hum = bme280_osr_hum_x1,
+        .standby = bme280_standbytime_1s,
+        .filter = bme280_filter_off,
+    };
+    bme280SetDeviceSettings(&bme280, &bme280_settings);
+
+    i2c_device_t tsl2561_i2c = i2cInitialize(&session->tsl2561_i2c_settings);
+    struct tsl2561_t tsl2561;
+    tsl2561Initialize(&tsl2561, tsl2561_i2c);
+
+    spi_device_t mcp3002_spi = spiInitialize(&session->mcp3002_spi_settings);
+    struct mcp3002_t mcp3002;
+    mcp3002Initialize(&mcp3002, mcp3002_spi);
+    struct mcp3002_settings_t mcp3002_settings = {
+        .base_voltage = 3300,
+    };
+    mcp3002SetDeviceSettings(&mcp3002, &mcp3002_settings);
+
+    // Interleave reads the way a polling loop over the fleet would
+    uint64_t start = clockGetTime();
+    for (uint32_t i = 0; i < TRACE_READS; i++) {
+        struct bme280_data_t bme280_data;
+        struct mcp3002_data_t mcp3002_data;
+        bme280ReadDeviceData(&bme280, &bme280_data);
+        mcp3002ReadDeviceData(&mcp3002, &mcp3002_data);
+        checksum = checksum * 31 + bme280_data.temperature;
+        checksum = checksum * 31 + bme280_data.pressure;
+        checksum = checksum * 31 + bme280_data.humidity;
+        checksum = checksum * 31 + mcp3002_data.single_0;
+        checksum = checksum * 31 + mcp3002_data.differential_0;
+    }
+    session->time = clockGetTime() - start;
+
+    spiFinalize(bme280_spi);
+    i2cFinalize(tsl2561_i2c);
+    spiFinalize(mcp3002_spi);
+    session->checksum = checksum;
+}
+
+static void traceReport(char const* variant, struct trace_session_t* session,
+                        uint64_t transactions, uint64_t mismatches) {
+    double ops = (double)TRACE_READS * 2;
+    printf("{\"name\":\"trace_replay\",\"variant\":\"%s\",\"ops\":%.0f,"
+           "\"ns_per_op\":%.3f,\"ops_per_s\":%.0f,\"transactions\":%llu,"
+           "\"mismatches\":%llu,\"checksum\":\"%016llx\"}\n",
+           variant, ops, session->time / ops, ops * 1e9 / session->time,
+           (unsigned long long)transactions, (unsigned long long)mismatches,
+           (unsigned long long)session->checksum);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    char const* path = argc > 1 ? argv[1] : "trace_replay.bin";
+    uint8_t paced = argc > 2 && strcmp(argv[2], "paced") == 0;
+
+    // Record a session against the simulated devices
+    struct bme280_sim_t bme280_sim;
+    bme280SimInitialize(&bme280_sim, NULL);
+    struct tsl2561_sim_t tsl2561_sim;
+    tsl2561SimInitialize(&tsl2561_sim, NULL);
+    struct mcp3002_sim_t mcp3002_sim;
+    mcp3002SimInitialize(&mcp3002_sim, NULL);
+
+    struct trace_recorder_t recorder;
+    if (traceRecorderOpen(&recorder, path) != 0) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+    struct trace_settings_t bme280_trace = {
+        .recorder = &recorder,
+        .spi_backend = &bme280_sim_backend,
+        .backend_data = &bme280_sim,
+    };
+    struct trace_settings_t tsl2561_trace = {
+        .recorder = &recorder,
+        .i2c_backend = &tsl2561_sim_backend,
+        .backend_data = &tsl2561_sim,
+    };
+    struct trace_settings_t mcp3002_trace = {
+        .recorder = &recorder,
+        .spi_backend = &mcp3002_sim_backend,
+        .backend_data = &mcp3002_sim,
+    };
+    struct trace_session_t record = {
+        .bme280_spi_settings = {.backend = &trace_spi_backend,
+                                .backend_data = &bme280_trace},
+        .tsl2561_i2c_settings = {.backend = &trace_i2c_backend,
+                                 .backend_data = &tsl2561_trace},
+        .mcp3002_spi_settings = {.backend = &trace_spi_backend,
+                                 .backend_data = &mcp3002_trace},
+    };
+    traceSessionRun(&record);
+    traceRecorderClose(&recorder);
+    traceReport("record", &record, 0, 0);
+
+    // Replay the trace and check the drivers see the same data
+    struct trace_replay_t replay;
+    if (traceReplayOpen(&replay, path, paced) != 0) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return 1;
+    }
+    struct trace_session_t session = {
+        .bme280_spi_settings = {.backend = &trace_replay_spi_backend,
+                                .backend_data = &replay},
+        .tsl2561_i2c_settings = {.backend = &trace_replay_i2c_backend,
+                                 .backend_data = &replay},
+        .mcp3002_spi_settings = {.backend = &trace_replay_spi_backend,
+                                 .backend_data = &replay},
+    };
+    traceSessionRun(&session);
+    traceReport(paced ? "replay_paced" : "replay", &session,
+                replay.transactions, replay.mismatches);
+    uint8_t failed = replay.mismatches != 0 ||
+                     session.checksum != record.checksum;
+    traceReplayClose(&replay);
+    return failed;
+}
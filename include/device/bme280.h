@@ -9,6 +9,10 @@ extern "C" {
 
 #include "interface/spi.h"
 
+#define BME280_CACHE_MAX 64
+#define BME280_CALIB_REG_SIZE 32
+#define BME280_FINGERPRINT_SIZE 8
+
 enum bme280_osr_temp_t {
     bme280_osr_temp_skip = 0x00,
     bme280_osr_temp_x1 = 0x20,
@@ -92,25 +96,130 @@ struct bme280_calib_data_t {
     int32_t t_fine;
 };
 
+#ifdef BME280_FLOAT_ENABLE
+
+struct bme280_compensation_t {
+    double dig_t1_div1024;
+    double dig_t1_div8192;
+    double dig_t2;
+    double dig_t3;
+    double dig_p1;
+    double dig_p2;
+    double dig_p3;
+    double dig_p4_x65536;
+    double dig_p5;
+    double dig_p6;
+    double dig_p7;
+    double dig_p8;
+    double dig_p9;
+    double dig_h1;
+    double dig_h2_div65536;
+    double dig_h3_div67108864;
+    double dig_h4_x64;
+    double dig_h5_div16384;
+    double dig_h6_div67108864;
+};
+
+#else
+
+struct bme280_compensation_t {
+    int32_t dig_t1;
+    int32_t dig_t1_x2;
+    int32_t dig_t2;
+    int32_t dig_t3;
+    int32_t dig_p4_x65536;
+    int32_t dig_h4_x1048576;
+    uint16_t dig_p1;
+    int16_t dig_p2;
+    int16_t dig_p3;
+    int16_t dig_p5;
+    int16_t dig_p6;
+    int16_t dig_p7;
+    int16_t dig_p8;
+    int16_t dig_p9;
+    int16_t dig_h2;
+    int16_t dig_h5;
+    uint8_t dig_h1;
+    uint8_t dig_h3;
+    int8_t dig_h6;
+};
+
+#endif
+
 struct bme280_data_t {
     uint32_t temperature;
     uint32_t pressure;
     uint32_t humidity;
 };
 
+#ifdef BME280_FLOAT_ENABLE
+
+struct bme280_measurement_t {
+    double temperature;
+    double pressure;
+    double humidity;
+};
+
+#else
+
+struct bme280_measurement_t {
+    int32_t temperature;
+    uint32_t pressure;
+    uint32_t humidity;
+};
+
+#endif
+
 struct bme280_t {
     spi_device_t spi_device;
     struct bme280_settings_t settings;
     struct bme280_calib_data_t calib_data;
+    struct bme280_compensation_t compensation;
+    uint64_t ready_time;
+};
+
+struct bme280_cache_entry_t {
+    uint8_t bus_number;
+    uint8_t slave_number;
+    uint8_t chip_id;
+    uint8_t calib_reg[BME280_CALIB_REG_SIZE];
+};
+
+struct bme280_cache_t {
+    uint32_t count;
+    uint8_t modified;
+    struct bme280_cache_entry_t entries[BME280_CACHE_MAX];
 };
 
 void bme280Initialize(struct bme280_t* device, spi_device_t spi_device);
+void bme280InitializeCached(struct bme280_t* device, spi_device_t spi_device,
+                            struct bme280_cache_t* cache);
+int8_t bme280StartInitialize(struct bme280_t* device, spi_device_t spi_device,
+                             struct bme280_cache_t* cache,
+                             uint64_t* ready_time);
+int8_t bme280FinishInitialize(struct bme280_t* device,
+                              struct bme280_cache_t* cache);
+
+void bme280CacheInitialize(struct bme280_cache_t* cache);
+int8_t bme280CacheLoad(struct bme280_cache_t* cache, char const* path);
+int8_t bme280CacheSave(struct bme280_cache_t* cache, char const* path);
+void bme280CacheMerge(struct bme280_cache_t* cache,
+                      struct bme280_cache_t const* source);
 
 void bme280SetDeviceSettings(struct bme280_t* device,
                              struct bme280_settings_t* settings);
+void bme280PrepareCompensation(struct bme280_t* device);
 
 void bme280ReadDeviceData(struct bme280_t* device, struct bme280_data_t* data);
 
+uint32_t bme280GetMeasurementTime(struct bme280_t* device);
+uint64_t bme280StartConversion(struct bme280_t* device);
+uint64_t bme280GetReadyTime(struct bme280_t* device);
+int8_t bme280FetchDeviceData(struct bme280_t* device,
+                             struct bme280_data_t* data);
+void bme280DecodeDeviceData(uint8_t const* data_reg,
+                            struct bme280_data_t* data);
+
 #ifdef BME280_FLOAT_ENABLE
 
 double bme280CalculateTemperature(struct bme280_t* device,
@@ -120,6 +229,15 @@ double bme280CalculatePressure(struct bme280_t* device,
 double bme280CalculateHumidity(struct bme280_t* device,
                                struct bme280_data_t* data);
 
+void bme280CompensateBatch(struct bme280_t* device,
+                           uint32_t const* raw_temperature,
+                           uint32_t const* raw_pressure,
+                           uint32_t const* raw_humidity, double* temperature,
+                           double* pressure, double* humidity, uint32_t count);
+void bme280Compensate(struct bme280_compensation_t const* compensation,
+                      struct bme280_data_t const* data,
+                      struct bme280_measurement_t* measurement);
+
 #else
 
 int32_t bme280CalculateTemperature(struct bme280_t* device,
@@ -129,6 +247,19 @@ uint32_t bme280CalculatePressure(struct bme280_t* device,
 uint32_t bme280CalculateHumidity(struct bme280_t* device,
                                  struct bme280_data_t* data);
 
+// Matches bme280Compensate bit for bit for any 20 bit temperature and pressure
+// and 16 bit humidity reading with a device's calibration. Past -40 or 85 C the
+// pressure and humidity are compensated at the clamped temperature.
+void bme280CompensateBatch(struct bme280_t* device,
+                           uint32_t const* raw_temperature,
+                           uint32_t const* raw_pressure,
+                           uint32_t const* raw_humidity, int32_t* temperature,
+                           uint32_t* pressure, uint32_t* humidity,
+                           uint32_t count);
+void bme280Compensate(struct bme280_compensation_t const* compensation,
+                      struct bme280_data_t const* data,
+                      struct bme280_measurement_t* measurement);
+
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,54 @@
+#ifndef __BME280_STREAM_H__
+#define __BME280_STREAM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "device/bme280.h"
+
+struct bme280_stream_statistics_t {
+    double rate;
+    double period;
+    uint64_t samples;
+    uint64_t duplicates;
+    uint64_t missed;
+    uint64_t transfers;
+};
+
+struct bme280_stream_t {
+    struct bme280_t* device;
+    uint64_t nominal_period;
+    uint64_t period;
+    uint64_t edge_time;
+    uint64_t early_time;
+    uint64_t ready_time;
+    uint64_t start_time;
+    uint8_t data_reg[8];
+    uint64_t samples;
+    uint64_t duplicates;
+    uint64_t missed;
+    uint64_t transfers;
+};
+
+int8_t bme280StreamStart(struct bme280_stream_t* stream,
+                         struct bme280_t* device,
+                         struct bme280_settings_t* settings);
+void bme280StreamStop(struct bme280_stream_t* stream);
+
+uint64_t bme280StreamGetReadyTime(struct bme280_stream_t* stream);
+int8_t bme280StreamFetch(struct bme280_stream_t* stream,
+                         struct bme280_data_t* data, uint64_t* timestamp);
+void bme280StreamRead(struct bme280_stream_t* stream,
+                      struct bme280_data_t* data, uint64_t* timestamp);
+
+void bme280StreamGetStatistics(struct bme280_stream_t* stream,
+                               struct bme280_stream_statistics_t* statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
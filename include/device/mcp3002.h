@@ -16,6 +16,14 @@ enum mcp3002_channel_t {
     mcp3002_channel_single_1 = 0x30,
 };
 
+enum mcp3002_channel_mask_t {
+    mcp3002_channel_mask_differential_0 = 0x01,
+    mcp3002_channel_mask_differential_1 = 0x02,
+    mcp3002_channel_mask_single_0 = 0x04,
+    mcp3002_channel_mask_single_1 = 0x08,
+    mcp3002_channel_mask_all = 0x0F,
+};
+
 #ifdef MCP3002_FLOAT_ENABLE
 
 struct mcp3002_settings_t {
@@ -49,6 +57,10 @@ void mcp3002SetDeviceSettings(struct mcp3002_t* device,
 
 void mcp3002ReadDeviceData(struct mcp3002_t* device,
                            struct mcp3002_data_t* data);
+uint16_t mcp3002ReadChannel(struct mcp3002_t* device,
+                            enum mcp3002_channel_t channel);
+void mcp3002ReadChannels(struct mcp3002_t* device, uint8_t channel_mask,
+                         uint16_t count, uint16_t* values);
 
 #ifdef MCP3002_FLOAT_ENABLE
 
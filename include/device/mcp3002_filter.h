@@ -0,0 +1,104 @@
+#ifndef __MCP3002_FILTER_H__
+#define __MCP3002_FILTER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define MCP3002_FILTER_STAGE_MAX 8
+#define MCP3002_FILTER_BLOCK 256
+#define MCP3002_FILTER_CIC_ORDER_MAX 4
+#define MCP3002_FILTER_TAP_MAX 64
+
+// Samples travel between stages as codes with 4 fractional bits, FIR taps
+// are Q15 and biquad coefficients Q14
+#define MCP3002_FILTER_SHIFT 4
+#define MCP3002_FILTER_FIR_SHIFT 15
+#define MCP3002_FILTER_BIQUAD_SHIFT 14
+
+enum mcp3002_filter_type_t {
+    mcp3002_filter_cic = 0,
+    mcp3002_filter_fir = 1,
+    mcp3002_filter_biquad = 2,
+};
+
+struct mcp3002_cic_t {
+    uint8_t order;
+    uint16_t ratio;
+    uint16_t phase;
+    int64_t gain;
+    int32_t integrator[MCP3002_FILTER_CIC_ORDER_MAX];
+    int32_t comb[MCP3002_FILTER_CIC_ORDER_MAX];
+};
+
+struct mcp3002_fir_t {
+    uint16_t ratio;
+    uint16_t phase;
+    uint16_t tap_count;
+    uint16_t index;
+    int32_t taps[MCP3002_FILTER_TAP_MAX];
+    int32_t history[2 * MCP3002_FILTER_TAP_MAX];
+};
+
+struct mcp3002_biquad_t {
+    int32_t b0;
+    int32_t b1;
+    int32_t b2;
+    int32_t a1;
+    int32_t a2;
+    int32_t x1;
+    int32_t x2;
+    int32_t y1;
+    int32_t y2;
+};
+
+struct mcp3002_filter_stage_t {
+    enum mcp3002_filter_type_t type;
+    union {
+        struct mcp3002_cic_t cic;
+        struct mcp3002_fir_t fir;
+        struct mcp3002_biquad_t biquad;
+    } state;
+};
+
+struct mcp3002_filter_statistics_t {
+    uint64_t samples_in;
+    uint64_t samples_out;
+    uint32_t ratio;
+    double ns_per_sample;
+};
+
+struct mcp3002_filter_t {
+    struct mcp3002_filter_stage_t stages[MCP3002_FILTER_STAGE_MAX];
+    uint8_t stage_count;
+    uint32_t ratio;
+    int32_t block[MCP3002_FILTER_BLOCK];
+    uint64_t samples_in;
+    uint64_t samples_out;
+    uint64_t time;
+};
+
+void mcp3002FilterInitialize(struct mcp3002_filter_t* filter);
+int8_t mcp3002FilterAddCic(struct mcp3002_filter_t* filter, uint8_t order,
+                           uint16_t ratio);
+int8_t mcp3002FilterAddFir(struct mcp3002_filter_t* filter,
+                           int16_t const* taps, uint16_t tap_count,
+                           uint16_t ratio);
+int8_t mcp3002FilterAddBiquad(struct mcp3002_filter_t* filter,
+                              int32_t const* coefficients);
+void mcp3002FilterReset(struct mcp3002_filter_t* filter);
+
+uint32_t mcp3002FilterProcess(struct mcp3002_filter_t* filter,
+                              uint16_t const* codes, uint32_t count,
+                              uint16_t* output);
+
+void mcp3002FilterGetStatistics(struct mcp3002_filter_t* filter,
+                                struct mcp3002_filter_statistics_t* statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
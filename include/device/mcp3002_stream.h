@@ -0,0 +1,63 @@
+#ifndef __MCP3002_STREAM_H__
+#define __MCP3002_STREAM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "device/mcp3002.h"
+
+struct mcp3002_sample_t {
+    uint64_t timestamp;
+    uint16_t value;
+    enum mcp3002_channel_t channel;
+};
+
+struct mcp3002_stream_settings_t {
+    uint8_t channel_mask;
+    uint32_t rate;
+    uint32_t capacity;
+};
+
+struct mcp3002_stream_statistics_t {
+    double rate;
+    uint64_t samples;
+    uint64_t overruns;
+    uint64_t dropped;
+};
+
+struct mcp3002_stream_t {
+    struct mcp3002_t* device;
+    struct mcp3002_stream_settings_t settings;
+    struct mcp3002_sample_t* buffer;
+    uint32_t mask;
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    _Atomic uint64_t samples;
+    _Atomic uint64_t overruns;
+    _Atomic uint64_t dropped;
+    _Atomic uint8_t running;
+    uint64_t start_time;
+    pthread_t thread;
+};
+
+int8_t mcp3002StreamStart(struct mcp3002_stream_t* stream,
+                          struct mcp3002_t* device,
+                          struct mcp3002_stream_settings_t* settings);
+void mcp3002StreamStop(struct mcp3002_stream_t* stream);
+
+uint32_t mcp3002StreamRead(struct mcp3002_stream_t* stream,
+                           struct mcp3002_sample_t* samples, uint32_t count);
+
+void mcp3002StreamGetStatistics(struct mcp3002_stream_t* stream,
+                                struct mcp3002_stream_statistics_t* statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
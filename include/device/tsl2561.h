@@ -24,9 +24,15 @@ enum tsl2561_integral_t {
     tsl2561_integral_402ms = 0x02,
 };
 
+enum tsl2561_mode_t {
+    tsl2561_mode_oneshot = 0x00,
+    tsl2561_mode_continuous = 0x01,
+};
+
 struct tsl2561_settings_t {
     enum tsl2561_gain_t gain;
     enum tsl2561_integral_t integral;
+    enum tsl2561_mode_t mode;
 };
 
 struct tsl2561_data_t {
@@ -37,9 +43,14 @@ struct tsl2561_data_t {
 struct tsl2561_t {
     i2c_device_t i2c_device;
     struct tsl2561_settings_t settings;
+    uint64_t integration_start;
+    uint64_t integration_count;
 };
 
 void tsl2561Initialize(struct tsl2561_t* device, i2c_device_t i2c_device);
+int8_t tsl2561StartInitialize(struct tsl2561_t* device,
+                              i2c_device_t i2c_device, uint64_t* ready_time);
+int8_t tsl2561FinishInitialize(struct tsl2561_t* device);
 
 void tsl2561SetDeviceSettings(struct tsl2561_t* device,
                               struct tsl2561_settings_t* settings);
@@ -47,15 +58,26 @@ void tsl2561SetDeviceSettings(struct tsl2561_t* device,
 void tsl2561ReadDeviceData(struct tsl2561_t* device,
                            struct tsl2561_data_t* data);
 
+uint64_t tsl2561StartConversion(struct tsl2561_t* device);
+uint64_t tsl2561GetReadyTime(struct tsl2561_t* device);
+int8_t tsl2561FetchDeviceData(struct tsl2561_t* device,
+                              struct tsl2561_data_t* data);
+
 #ifdef TSL2561_FLOAT_ENABLE
 
 double tsl2561CalculateIlluminance(struct tsl2561_t* device,
                                    struct tsl2561_data_t* data);
+void tsl2561CalculateIlluminanceBatch(struct tsl2561_t* device,
+                                      struct tsl2561_data_t const* data,
+                                      double* illuminance, uint32_t count);
 
 #else
 
 uint32_t tsl2561CalculateIlluminance(struct tsl2561_t* device,
                                      struct tsl2561_data_t* data);
+void tsl2561CalculateIlluminanceBatch(struct tsl2561_t* device,
+                                      struct tsl2561_data_t const* data,
+                                      uint32_t* illuminance, uint32_t count);
 
 #endif
 
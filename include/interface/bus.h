@@ -0,0 +1,90 @@
+#ifndef __BUS_H__
+#define __BUS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "interface/i2c.h"
+#include "interface/spi.h"
+
+struct bus_transaction_t;
+
+typedef void (*bus_callback_t)(struct bus_transaction_t* transaction);
+
+enum bus_operation_t {
+    bus_operation_spi_transfer = 0x00,
+    bus_operation_spi_transfer_batch = 0x01,
+    bus_operation_i2c_write = 0x02,
+    bus_operation_i2c_read = 0x03,
+    bus_operation_i2c_write_read = 0x04,
+};
+
+struct bus_executor_t {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t submitted;
+    pthread_cond_t completed;
+    struct bus_transaction_t* head;
+    struct bus_transaction_t* tail;
+    uint8_t running;
+};
+
+struct bus_settings_t {
+    struct bus_executor_t* executor;
+    struct spi_backend_t const* spi_backend;
+    struct i2c_backend_t const* i2c_backend;
+    void* backend_data;
+};
+
+struct bus_device_t {
+    struct bus_executor_t* executor;
+    struct spi_backend_t const* spi_backend;
+    struct i2c_backend_t const* i2c_backend;
+    void* context;
+};
+
+struct bus_transaction_t {
+    enum bus_operation_t operation;
+    struct bus_device_t* device;
+    uint8_t* tx_buffer;
+    uint16_t tx_length;
+    uint8_t* rx_buffer;
+    uint16_t rx_length;
+    struct spi_segment_t* segments;
+    uint8_t count;
+    int32_t result;
+    bus_callback_t callback;
+    void* context;
+    _Atomic uint8_t done;
+    struct bus_transaction_t* next;
+};
+
+extern struct spi_backend_t const bus_spi_backend;
+extern struct i2c_backend_t const bus_i2c_backend;
+
+int8_t busInitialize(struct bus_executor_t* executor);
+void busFinalize(struct bus_executor_t* executor);
+
+void busSubmit(struct bus_transaction_t* transaction);
+int32_t busWait(struct bus_transaction_t* transaction);
+
+int8_t busSpiTransfer(struct bus_transaction_t* transaction,
+                      spi_device_t device, uint8_t* tx_buffer,
+                      uint8_t* rx_buffer, uint16_t length,
+                      bus_callback_t callback, void* context);
+int8_t busI2cWriteRead(struct bus_transaction_t* transaction,
+                       i2c_device_t device, uint8_t* tx_buffer,
+                       uint16_t tx_length, uint8_t* rx_buffer,
+                       uint16_t rx_length, bus_callback_t callback,
+                       void* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
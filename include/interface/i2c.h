@@ -7,18 +7,44 @@ extern "C" {
 
 #include <stdint.h>
 
+struct i2c_settings_t;
+
+struct i2c_backend_t {
+    int32_t (*open)(struct i2c_settings_t* settings, void** context);
+    void (*close)(void* context);
+    int32_t (*write)(void* context, uint8_t* tx_buffer, uint16_t length);
+    int32_t (*read)(void* context, uint8_t* rx_buffer, uint16_t length);
+    int32_t (*write_read)(void* context, uint8_t* tx_buffer,
+                          uint16_t tx_length, uint8_t* rx_buffer,
+                          uint16_t rx_length);
+};
+
+#ifdef PIGPIO_ENABLE
+extern struct i2c_backend_t const i2c_backend_pigpio;
+#endif
+extern struct i2c_backend_t const i2c_backend_i2cdev;
+
 struct i2c_settings_t {
     uint8_t bus_number;
     uint8_t address;
+    struct i2c_backend_t const* backend;
+    void* backend_data;
 };
 
 typedef uint8_t i2c_device_t;
 
 i2c_device_t i2cInitialize(struct i2c_settings_t* settings);
 void i2cFinalize(i2c_device_t device);
+void* i2cGetContext(i2c_device_t device);
+struct i2c_backend_t const* i2cGetBackend(i2c_device_t device);
+uint8_t i2cGetBusNumber(i2c_device_t device);
 
 void i2cWrite(i2c_device_t device, uint8_t* tx_buffer, uint16_t length);
 void i2cRead(i2c_device_t device, uint8_t* rx_buffer, uint16_t length);
+void i2cWriteRead(i2c_device_t device, uint8_t* tx_buffer, uint16_t tx_length,
+                  uint8_t* rx_buffer, uint16_t rx_length);
+void i2cReadBlock(i2c_device_t device, uint8_t address, uint8_t* rx_buffer,
+                  uint16_t length);
 
 #ifdef __cplusplus
 }
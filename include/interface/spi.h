@@ -12,20 +12,55 @@ enum spi_active_high_t {
     spi_active_high_enable = 0x04,
 };
 
+struct spi_settings_t;
+
+struct spi_segment_t {
+    uint8_t* tx_buffer;
+    uint8_t* rx_buffer;
+    uint16_t length;
+    uint8_t cs_change;
+};
+
+struct spi_backend_t {
+    int32_t (*open)(struct spi_settings_t* settings, void** context);
+    void (*close)(void* context);
+    int32_t (*transfer)(void* context, uint8_t* tx_buffer, uint8_t* rx_buffer,
+                        uint16_t length);
+    int32_t (*transfer_batch)(void* context, struct spi_segment_t* segments,
+                              uint8_t count);
+};
+
+#ifdef PIGPIO_ENABLE
+extern struct spi_backend_t const spi_backend_pigpio;
+#endif
+extern struct spi_backend_t const spi_backend_spidev;
+
 struct spi_settings_t {
     uint8_t slave_number;
     uint32_t clock_speed;
     uint8_t mode_number;
     enum spi_active_high_t active_high;
+    uint8_t bus_number;
+    struct spi_backend_t const* backend;
+    void* backend_data;
 };
 
 typedef uint8_t spi_device_t;
 
 spi_device_t spiInitialize(struct spi_settings_t* settings);
 void spiFinalize(spi_device_t device);
+void* spiGetContext(spi_device_t device);
+struct spi_backend_t const* spiGetBackend(spi_device_t device);
+uint8_t spiGetBusNumber(spi_device_t device);
+uint8_t spiGetSlaveNumber(spi_device_t device);
 
 void spiTransfer(spi_device_t device, uint8_t* tx_buffer, uint8_t* rx_buffer,
                  uint16_t length);
+void spiTransferBatch(spi_device_t device, struct spi_segment_t* segments,
+                      uint8_t count);
+int32_t spiBackendTransferBatch(struct spi_backend_t const* backend,
+                                void* context, struct spi_segment_t* segments,
+                                uint8_t count);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,83 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "interface/i2c.h"
+#include "interface/spi.h"
+
+#define TRACE_DEVICE_MAX 32
+
+enum trace_operation_t {
+    trace_operation_spi_open = 0x00,
+    trace_operation_spi_transfer = 0x01,
+    trace_operation_spi_transfer_batch = 0x02,
+    trace_operation_i2c_open = 0x10,
+    trace_operation_i2c_write = 0x11,
+    trace_operation_i2c_read = 0x12,
+    trace_operation_i2c_write_read = 0x13,
+};
+
+struct trace_record_t {
+    uint64_t time;
+    uint32_t duration;
+    int32_t result;
+    uint32_t length;
+    uint8_t operation;
+    uint8_t device;
+    uint16_t count;
+};
+
+struct trace_recorder_t {
+    FILE* stream;
+    pthread_mutex_t mutex;
+    uint64_t start_time;
+    uint8_t spi_devices;
+    uint8_t i2c_devices;
+};
+
+struct trace_settings_t {
+    struct trace_recorder_t* recorder;
+    struct spi_backend_t const* spi_backend;
+    struct i2c_backend_t const* i2c_backend;
+    void* backend_data;
+};
+
+struct trace_replay_t {
+    uint8_t* data;
+    size_t size;
+    uint32_t* index[2][TRACE_DEVICE_MAX];
+    uint32_t index_count[2][TRACE_DEVICE_MAX];
+    uint8_t paced;
+    uint64_t start_time;
+    _Atomic uint8_t spi_devices;
+    _Atomic uint8_t i2c_devices;
+    _Atomic uint64_t transactions;
+    _Atomic uint64_t mismatches;
+};
+
+extern struct spi_backend_t const trace_spi_backend;
+extern struct i2c_backend_t const trace_i2c_backend;
+extern struct spi_backend_t const trace_replay_spi_backend;
+extern struct i2c_backend_t const trace_replay_i2c_backend;
+
+int8_t traceRecorderOpen(struct trace_recorder_t* recorder, char const* path);
+void traceRecorderClose(struct trace_recorder_t* recorder);
+
+int8_t traceReplayOpen(struct trace_replay_t* replay, char const* path,
+                       uint8_t paced);
+void traceReplayClose(struct trace_replay_t* replay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
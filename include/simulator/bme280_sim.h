@@ -0,0 +1,42 @@
+#ifndef __BME280_SIM_H__
+#define __BME280_SIM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "device/bme280.h"
+#include "interface/spi.h"
+#include "simulator/simulator.h"
+
+struct bme280_sim_settings_t {
+    struct bme280_calib_data_t const* calib_data;
+    uint32_t measurement_time;
+    uint32_t reset_time;
+    struct simulator_waveform_t temperature;
+    struct simulator_waveform_t pressure;
+    struct simulator_waveform_t humidity;
+};
+
+struct bme280_sim_t {
+    struct bme280_sim_settings_t settings;
+    uint8_t reg[256];
+    uint64_t reset_end;
+    uint64_t measurement_start;
+    uint64_t measurement_end;
+    uint64_t cycle_time;
+    uint8_t osr_hum;
+};
+
+extern struct spi_backend_t const bme280_sim_backend;
+
+void bme280SimInitialize(struct bme280_sim_t* sim,
+                         struct bme280_sim_settings_t* settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
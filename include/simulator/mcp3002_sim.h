@@ -0,0 +1,33 @@
+#ifndef __MCP3002_SIM_H__
+#define __MCP3002_SIM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "interface/spi.h"
+#include "simulator/simulator.h"
+
+struct mcp3002_sim_settings_t {
+    uint32_t conversion_time;
+    struct simulator_waveform_t channel_0;
+    struct simulator_waveform_t channel_1;
+};
+
+struct mcp3002_sim_t {
+    struct mcp3002_sim_settings_t settings;
+    uint64_t conversions;
+};
+
+extern struct spi_backend_t const mcp3002_sim_backend;
+
+void mcp3002SimInitialize(struct mcp3002_sim_t* sim,
+                          struct mcp3002_sim_settings_t* settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
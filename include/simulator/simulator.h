@@ -0,0 +1,32 @@
+#ifndef __SIMULATOR_H__
+#define __SIMULATOR_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+struct simulator_waveform_t {
+    uint32_t (*sample)(void* context, uint64_t time);
+    void* context;
+};
+
+struct simulator_sine_t {
+    uint32_t offset;
+    uint32_t amplitude;
+    uint32_t frequency;
+};
+
+uint64_t simulatorGetTime(void);
+
+uint32_t simulatorSampleWaveform(struct simulator_waveform_t* waveform,
+                                 uint64_t time, uint32_t value);
+
+uint32_t simulatorSine(void* context, uint64_t time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
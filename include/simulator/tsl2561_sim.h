@@ -0,0 +1,35 @@
+#ifndef __TSL2561_SIM_H__
+#define __TSL2561_SIM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "interface/i2c.h"
+#include "simulator/simulator.h"
+
+struct tsl2561_sim_settings_t {
+    uint32_t integration_time[3];
+    struct simulator_waveform_t channel_0;
+    struct simulator_waveform_t channel_1;
+};
+
+struct tsl2561_sim_t {
+    struct tsl2561_sim_settings_t settings;
+    uint8_t reg[16];
+    uint8_t pointer;
+    uint64_t integration_start;
+};
+
+extern struct i2c_backend_t const tsl2561_sim_backend;
+
+void tsl2561SimInitialize(struct tsl2561_sim_t* sim,
+                          struct tsl2561_sim_settings_t* settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
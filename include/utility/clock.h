@@ -0,0 +1,17 @@
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+uint64_t clockGetTime(void);
+void clockSleepUntil(uint64_t time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef __FLEET_H__
+#define __FLEET_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "device/bme280.h"
+#include "device/tsl2561.h"
+#include "interface/i2c.h"
+#include "interface/spi.h"
+
+#define FLEET_BUS_MAX 16
+
+enum fleet_device_type_t {
+    fleet_device_bme280 = 0,
+    fleet_device_tsl2561 = 1,
+};
+
+enum fleet_status_t {
+    fleet_status_pending = 0,
+    fleet_status_ready = 1,
+    fleet_status_cached = 2,
+    fleet_status_missing = -1,
+    fleet_status_timeout = -2,
+};
+
+struct fleet_device_t {
+    enum fleet_device_type_t type;
+    void* device;
+    spi_device_t spi_device;
+    i2c_device_t i2c_device;
+    enum fleet_status_t status;
+    uint64_t ready_time;
+    uint64_t time;
+};
+
+struct fleet_settings_t {
+    struct bme280_cache_t* bme280_cache;
+    uint64_t timeout;
+};
+
+uint64_t fleetInitialize(struct fleet_device_t* devices, uint32_t count,
+                         struct fleet_settings_t* settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef __HUB_H__
+#define __HUB_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+#include "utility/hub_protocol.h"
+#include "utility/sample.h"
+#include "utility/scheduler.h"
+
+#define HUB_DEVICE_MAX 32
+#define HUB_CONNECTION_MAX 32
+#define HUB_SUBSCRIPTION_MAX 16
+#define HUB_PATH_MAX 108
+
+struct hub_t;
+
+struct hub_device_t {
+    struct hub_t* hub;
+    uint32_t device_id;
+    enum sample_type_t type;
+    struct scheduler_task_t task;
+    union {
+        struct bme280_data_t bme280;
+        struct tsl2561_data_t tsl2561;
+        struct mcp3002_data_t mcp3002;
+    } data;
+};
+
+struct hub_subscription_t {
+    uint32_t device_id;
+    uint64_t period;
+    uint64_t next_time;
+};
+
+struct hub_connection_t {
+    struct scheduler_watch_t watch;
+    struct hub_t* hub;
+    uint8_t active;
+    uint32_t batch;
+    struct hub_subscription_t subscriptions[HUB_SUBSCRIPTION_MAX];
+    uint32_t subscription_count;
+    struct hub_frame_t frame;
+    uint64_t frames;
+    uint64_t dropped;
+};
+
+struct hub_t {
+    struct scheduler_t* scheduler;
+    struct scheduler_watch_t watch;
+    char path[HUB_PATH_MAX];
+    struct hub_device_t devices[HUB_DEVICE_MAX];
+    uint32_t device_count;
+    struct hub_connection_t connections[HUB_CONNECTION_MAX];
+};
+
+int8_t hubInitialize(struct hub_t* hub, struct scheduler_t* scheduler,
+                     char const* path);
+void hubFinalize(struct hub_t* hub);
+
+int8_t hubAddBme280(struct hub_t* hub, uint32_t device_id,
+                    struct bme280_t* device);
+int8_t hubAddTsl2561(struct hub_t* hub, uint32_t device_id,
+                     struct tsl2561_t* device);
+int8_t hubAddMcp3002(struct hub_t* hub, uint32_t device_id,
+                     struct mcp3002_t* device);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef __HUB_CLIENT_H__
+#define __HUB_CLIENT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "utility/hub_protocol.h"
+#include "utility/sample.h"
+
+struct hub_client_t {
+    int fd;
+};
+
+int8_t hubClientOpen(struct hub_client_t* client, char const* path);
+void hubClientClose(struct hub_client_t* client);
+
+int8_t hubClientSubscribe(struct hub_client_t* client, uint32_t device_id,
+                          uint64_t period, uint32_t batch);
+int8_t hubClientUnsubscribe(struct hub_client_t* client, uint32_t device_id);
+int32_t hubClientRead(struct hub_client_t* client, struct sample_t* samples,
+                      uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef __HUB_PROTOCOL_H__
+#define __HUB_PROTOCOL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "utility/sample.h"
+
+#define HUB_BATCH_MAX 64
+
+enum hub_message_type_t {
+    hub_message_subscribe = 0x01,
+    hub_message_unsubscribe = 0x02,
+    hub_message_samples = 0x03,
+};
+
+struct hub_request_t {
+    uint32_t type;
+    uint32_t device_id;
+    uint64_t period;
+    uint32_t batch;
+};
+
+struct hub_frame_t {
+    uint32_t type;
+    uint32_t count;
+    struct sample_t samples[HUB_BATCH_MAX];
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
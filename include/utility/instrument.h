@@ -0,0 +1,79 @@
+#ifndef __INSTRUMENT_H__
+#define __INSTRUMENT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define INSTRUMENT_BUS_MAX 8
+#define INSTRUMENT_DEVICE_MAX 32
+#define INSTRUMENT_BUCKET_MAX 32
+
+enum instrument_interface_t {
+    instrument_interface_spi = 0,
+    instrument_interface_i2c = 1,
+    instrument_interface_max = 2,
+};
+
+struct instrument_counter_t {
+    uint64_t transactions;
+    uint64_t bytes;
+    uint64_t errors;
+    uint64_t polls;
+    uint64_t delay_time;
+    uint64_t latency[INSTRUMENT_BUCKET_MAX];
+};
+
+struct instrument_snapshot_t {
+    struct instrument_counter_t bus[instrument_interface_max]
+                                   [INSTRUMENT_BUS_MAX];
+    struct instrument_counter_t device[instrument_interface_max]
+                                      [INSTRUMENT_DEVICE_MAX];
+    uint8_t device_bus[instrument_interface_max][INSTRUMENT_DEVICE_MAX];
+};
+
+void instrumentAttach(enum instrument_interface_t interface, uint8_t device,
+                      uint8_t bus_number);
+void instrumentTransaction(enum instrument_interface_t interface,
+                           uint8_t device, uint32_t bytes, int32_t result,
+                           uint64_t start);
+void instrumentPoll(enum instrument_interface_t interface, uint8_t device);
+void instrumentDelay(enum instrument_interface_t interface, uint8_t device,
+                     uint64_t start);
+
+void instrumentSnapshot(struct instrument_snapshot_t* snapshot);
+void instrumentReset(void);
+void instrumentDump(FILE* stream);
+
+#ifdef INSTRUMENT_ENABLE
+
+#include "utility/clock.h"
+
+#define INSTRUMENT_START(start) uint64_t start = clockGetTime()
+#define INSTRUMENT_ATTACH(interface, device, bus_number) \
+    instrumentAttach(interface, device, bus_number)
+#define INSTRUMENT_TRANSACTION(interface, device, bytes, result, start) \
+    instrumentTransaction(interface, device, bytes, result, start)
+#define INSTRUMENT_POLL(interface, device) instrumentPoll(interface, device)
+#define INSTRUMENT_DELAY(interface, device, start) \
+    instrumentDelay(interface, device, start)
+
+#else
+
+#define INSTRUMENT_START(start)
+#define INSTRUMENT_ATTACH(interface, device, bus_number) ((void)0)
+#define INSTRUMENT_TRANSACTION(interface, device, bytes, result, start) \
+    ((void)(result))
+#define INSTRUMENT_POLL(interface, device) ((void)(device))
+#define INSTRUMENT_DELAY(interface, device, start) ((void)(device))
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
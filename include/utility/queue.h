@@ -0,0 +1,54 @@
+#ifndef __QUEUE_H__
+#define __QUEUE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "utility/sample.h"
+
+#define QUEUE_CACHE_LINE 64
+
+struct spsc_queue_t {
+    _Alignas(QUEUE_CACHE_LINE) _Atomic uint64_t head;
+    uint64_t tail_cache;
+    _Alignas(QUEUE_CACHE_LINE) _Atomic uint64_t tail;
+    uint64_t head_cache;
+    _Alignas(QUEUE_CACHE_LINE) struct sample_t* buffer;
+    uint32_t mask;
+};
+
+struct mpsc_cell_t {
+    _Atomic uint64_t sequence;
+    struct sample_t sample;
+};
+
+struct mpsc_queue_t {
+    _Alignas(QUEUE_CACHE_LINE) _Atomic uint64_t head;
+    _Alignas(QUEUE_CACHE_LINE) uint64_t tail;
+    _Alignas(QUEUE_CACHE_LINE) struct mpsc_cell_t* cells;
+    uint32_t mask;
+};
+
+int8_t spscQueueInitialize(struct spsc_queue_t* queue, uint32_t capacity);
+void spscQueueFinalize(struct spsc_queue_t* queue);
+uint32_t spscQueuePush(struct spsc_queue_t* queue,
+                       struct sample_t const* samples, uint32_t count);
+uint32_t spscQueuePop(struct spsc_queue_t* queue, struct sample_t* samples,
+                      uint32_t count);
+
+int8_t mpscQueueInitialize(struct mpsc_queue_t* queue, uint32_t capacity);
+void mpscQueueFinalize(struct mpsc_queue_t* queue);
+uint32_t mpscQueuePush(struct mpsc_queue_t* queue,
+                       struct sample_t const* samples, uint32_t count);
+uint32_t mpscQueuePop(struct mpsc_queue_t* queue, struct sample_t* samples,
+                      uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef __SAMPLE_H__
+#define __SAMPLE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+
+enum sample_type_t {
+    sample_type_bme280 = 0x00,
+    sample_type_tsl2561 = 0x01,
+    sample_type_mcp3002 = 0x02,
+};
+
+struct sample_t {
+    uint64_t timestamp;
+    uint32_t device_id;
+    enum sample_type_t type;
+    union {
+        struct bme280_data_t bme280;
+        struct tsl2561_data_t tsl2561;
+        struct mcp3002_data_t mcp3002;
+    } data;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef __SAMPLE_LOG_H__
+#define __SAMPLE_LOG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+#include "utility/sample.h"
+
+#define SAMPLE_LOG_BLOCK_SAMPLES 1024
+#define SAMPLE_LOG_FIELD_MAX 4
+#define SAMPLE_LOG_SETTINGS_MAX 64
+
+struct sample_log_header_t {
+    enum sample_type_t type;
+    uint32_t device_id;
+    uint16_t settings_size;
+    uint8_t settings[SAMPLE_LOG_SETTINGS_MAX];
+};
+
+struct sample_log_writer_t {
+    FILE* stream;
+    struct sample_log_header_t header;
+    uint8_t field_count;
+    uint32_t count;
+    uint64_t* timestamp;
+    uint32_t* field[SAMPLE_LOG_FIELD_MAX];
+    uint8_t* buffer;
+};
+
+struct sample_log_block_t {
+    size_t offset;
+    uint32_t size;
+    uint32_t count;
+    uint64_t first_time;
+    uint64_t last_time;
+};
+
+struct sample_log_reader_t {
+    uint8_t const* data;
+    size_t size;
+    struct sample_log_header_t header;
+    uint8_t field_count;
+    struct sample_log_block_t* blocks;
+    uint32_t block_count;
+    uint64_t sample_count;
+};
+
+struct sample_log_columns_t {
+    uint64_t* timestamp;
+    uint32_t* field[SAMPLE_LOG_FIELD_MAX];
+};
+
+void sampleLogHeaderFromBme280(struct sample_log_header_t* header,
+                               uint32_t device_id,
+                               struct bme280_t const* device);
+void sampleLogHeaderFromTsl2561(struct sample_log_header_t* header,
+                                uint32_t device_id,
+                                struct tsl2561_t const* device);
+void sampleLogHeaderFromMcp3002(struct sample_log_header_t* header,
+                                uint32_t device_id,
+                                struct mcp3002_t const* device);
+int8_t sampleLogHeaderToBme280(struct sample_log_header_t const* header,
+                               struct bme280_t* device);
+int8_t sampleLogHeaderToTsl2561(struct sample_log_header_t const* header,
+                                struct tsl2561_t* device);
+int8_t sampleLogHeaderToMcp3002(struct sample_log_header_t const* header,
+                                struct mcp3002_t* device);
+
+int8_t sampleLogWriterOpen(struct sample_log_writer_t* writer,
+                           char const* path,
+                           struct sample_log_header_t const* header);
+int8_t sampleLogWriterAppend(struct sample_log_writer_t* writer,
+                             struct sample_t const* samples, uint32_t count);
+int8_t sampleLogWriterFlush(struct sample_log_writer_t* writer);
+int8_t sampleLogWriterClose(struct sample_log_writer_t* writer);
+
+int8_t sampleLogReaderOpen(struct sample_log_reader_t* reader,
+                           char const* path);
+void sampleLogReaderClose(struct sample_log_reader_t* reader);
+uint32_t sampleLogReaderSeek(struct sample_log_reader_t* reader,
+                             uint64_t time);
+uint32_t sampleLogReaderDecode(struct sample_log_reader_t* reader,
+                               uint32_t block,
+                               struct sample_log_columns_t* columns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
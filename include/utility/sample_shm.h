@@ -0,0 +1,71 @@
+#ifndef __SAMPLE_SHM_H__
+#define __SAMPLE_SHM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utility/sample.h"
+
+#define SAMPLE_SHM_CACHE_LINE 64
+#define SAMPLE_SHM_DEVICE_MAX 64
+
+struct sample_shm_slot_t {
+    _Alignas(SAMPLE_SHM_CACHE_LINE) _Atomic uint32_t sequence;
+    struct sample_t sample;
+};
+
+struct sample_shm_cell_t {
+    _Atomic uint64_t sequence;
+    struct sample_t sample;
+};
+
+struct sample_shm_region_t {
+    _Atomic uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    _Alignas(SAMPLE_SHM_CACHE_LINE) _Atomic uint64_t head;
+    _Atomic uint64_t publish_time;
+    struct sample_shm_slot_t latest[SAMPLE_SHM_DEVICE_MAX];
+    _Alignas(SAMPLE_SHM_CACHE_LINE) struct sample_shm_cell_t history[];
+};
+
+struct sample_shm_publisher_t {
+    struct sample_shm_region_t* region;
+    size_t size;
+    uint64_t mask;
+};
+
+struct sample_shm_reader_t {
+    struct sample_shm_region_t const* region;
+    size_t size;
+    uint64_t mask;
+    uint64_t cursor;
+    uint64_t lost;
+};
+
+int8_t sampleShmPublisherOpen(struct sample_shm_publisher_t* publisher,
+                              char const* name, uint32_t capacity);
+void sampleShmPublisherClose(struct sample_shm_publisher_t* publisher);
+void sampleShmPublish(struct sample_shm_publisher_t* publisher,
+                      struct sample_t const* samples, uint32_t count);
+int8_t sampleShmRemove(char const* name);
+
+int8_t sampleShmReaderOpen(struct sample_shm_reader_t* reader,
+                           char const* name);
+void sampleShmReaderClose(struct sample_shm_reader_t* reader);
+int8_t sampleShmReaderGetLatest(struct sample_shm_reader_t* reader,
+                                uint32_t device_id, struct sample_t* sample);
+uint32_t sampleShmReaderRead(struct sample_shm_reader_t* reader,
+                             struct sample_t* samples, uint32_t count);
+uint64_t sampleShmReaderGetPublishTime(struct sample_shm_reader_t* reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
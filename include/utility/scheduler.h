@@ -0,0 +1,102 @@
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+
+#define SCHEDULER_EVENT_MAX 16
+
+struct scheduler_task_t;
+struct scheduler_watch_t;
+
+typedef uint64_t (*scheduler_start_t)(struct scheduler_task_t* task);
+typedef int8_t (*scheduler_fetch_t)(struct scheduler_task_t* task);
+typedef void (*scheduler_callback_t)(struct scheduler_task_t* task);
+typedef void (*scheduler_watch_callback_t)(struct scheduler_watch_t* watch,
+                                           uint32_t events);
+
+struct scheduler_statistics_t {
+    uint64_t count;
+    double period;
+    double jitter;
+    uint64_t latency_max;
+};
+
+struct scheduler_task_t {
+    uint64_t period;
+    scheduler_start_t start;
+    scheduler_fetch_t fetch;
+    scheduler_callback_t callback;
+    void* device;
+    void* data;
+    void* context;
+    struct scheduler_task_t* next;
+    uint64_t start_time;
+    uint64_t ready_time;
+    uint8_t pending;
+    uint64_t last_start;
+    uint64_t count;
+    double period_mean;
+    double period_m2;
+    uint64_t latency_max;
+};
+
+struct scheduler_watch_t {
+    int fd;
+    uint32_t events;
+    scheduler_watch_callback_t callback;
+    void* context;
+};
+
+struct scheduler_t {
+    struct scheduler_task_t* tasks;
+    int timer_fd;
+    int event_fd;
+    int epoll_fd;
+    _Atomic uint8_t running;
+};
+
+int8_t schedulerInitialize(struct scheduler_t* scheduler);
+void schedulerFinalize(struct scheduler_t* scheduler);
+
+void schedulerAddTask(struct scheduler_t* scheduler,
+                      struct scheduler_task_t* task);
+void schedulerSetTaskPeriod(struct scheduler_task_t* task, uint64_t period);
+
+int8_t schedulerAddWatch(struct scheduler_t* scheduler,
+                         struct scheduler_watch_t* watch);
+void schedulerRemoveWatch(struct scheduler_t* scheduler,
+                          struct scheduler_watch_t* watch);
+
+void schedulerRun(struct scheduler_t* scheduler);
+void schedulerStop(struct scheduler_t* scheduler);
+
+void schedulerGetStatistics(struct scheduler_task_t* task,
+                            struct scheduler_statistics_t* statistics);
+
+void schedulerInitializeBme280Task(struct scheduler_task_t* task,
+                                   struct bme280_t* device,
+                                   struct bme280_data_t* data,
+                                   uint64_t period);
+void schedulerInitializeTsl2561Task(struct scheduler_task_t* task,
+                                    struct tsl2561_t* device,
+                                    struct tsl2561_data_t* data,
+                                    uint64_t period);
+void schedulerInitializeMcp3002Task(struct scheduler_task_t* task,
+                                    struct mcp3002_t* device,
+                                    struct mcp3002_data_t* data,
+                                    uint64_t period);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,12 +1,18 @@
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "device/bme280.h"
 #include "interface/spi.h"
+#include "utility/clock.h"
+#include "utility/instrument.h"
 
 #include <unistd.h>
-void delay(uint16_t ms) {
+static void delay(spi_device_t device, uint16_t ms) {
+    INSTRUMENT_START(start);
     usleep(ms * 1000);
+    INSTRUMENT_DELAY(instrument_interface_spi, device, start);
 }
 
 static uint8_t const bme280_temp_pres_calib_data_addr = 0x88;
@@ -25,6 +31,12 @@ static uint8_t const bme280_status_update = 0x01;
 static uint8_t const bme280_status_measuring = 0x08;
 static uint8_t const bme280_reset_command = 0xB6;
 
+static uint8_t const bme280_osr[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+
+static uint64_t const bme280_reset_time = 2000000;
+
+static char const bme280_cache_magic[8] = "BME280C";
+
 #ifdef BME280_FLOAT_ENABLE
 
 static double const bme280_temperature_max = 85.0;
@@ -38,16 +50,30 @@ static double const bme280_humidity_min = 0.0;
 
 static int32_t const bme280_temperature_max = 8500;
 static int32_t const bme280_temperature_min = -4000;
+// t_fine at the temperature limits, the pressure and humidity formulas only
+// stay inside 32 bits for a t_fine in this range
+static int32_t const bme280_t_fine_max = 8500 * 256 / 5;
+static int32_t const bme280_t_fine_min = -4000 * 256 / 5;
 static uint32_t const bme280_pressure_max = 110000;
 static uint32_t const bme280_pressure_min = 30000;
 static uint32_t const bme280_humidity_max = 102400;
 
 #endif
 
-static void bme280ReadCalibData(spi_device_t spi_device,
-                                struct bme280_calib_data_t* data);
+static void bme280ReadCalibReg(spi_device_t spi_device, uint8_t* reg_data);
+static void bme280DecodeCalibData(uint8_t const* reg_data,
+                                  struct bme280_calib_data_t* data);
+static void bme280ReadFingerprint(spi_device_t spi_device, uint8_t* chip_id,
+                                  uint8_t* status, uint8_t* fingerprint);
+static struct bme280_cache_entry_t* bme280CacheFind(
+    struct bme280_cache_t* cache, spi_device_t spi_device);
+static void bme280CacheStore(struct bme280_cache_t* cache,
+                             struct bme280_cache_entry_t* entry,
+                             spi_device_t spi_device, uint8_t chip_id,
+                             uint8_t const* calib_reg);
 
-static void bme280Reset(struct bme280_t* device);
+static void bme280Configure(struct bme280_t* device,
+                            uint8_t const* calib_reg);
 
 static void bme280SetSettingsReg(struct bme280_t* device);
 
@@ -56,22 +82,74 @@ static void bme280GetReg(spi_device_t device, uint8_t address, uint8_t* data,
                          uint8_t len);
 
 void bme280Initialize(struct bme280_t* device, spi_device_t spi_device) {
+    bme280InitializeCached(device, spi_device, NULL);
+}
+
+void bme280InitializeCached(struct bme280_t* device, spi_device_t spi_device,
+                            struct bme280_cache_t* cache) {
+    uint64_t ready_time;
+    if (bme280StartInitialize(device, spi_device, cache, &ready_time) != 0) {
+        return;
+    }
+    INSTRUMENT_START(start);
+    clockSleepUntil(ready_time);
+    INSTRUMENT_DELAY(instrument_interface_spi, device->spi_device, start);
+    while (bme280FinishInitialize(device, cache) != 0) {
+        INSTRUMENT_POLL(instrument_interface_spi, device->spi_device);
+        delay(device->spi_device, 1);
+    }
+}
+
+int8_t bme280StartInitialize(struct bme280_t* device, spi_device_t spi_device,
+                             struct bme280_cache_t* cache,
+                             uint64_t* ready_time) {
     device->spi_device = spi_device;
-    struct bme280_settings_t settings = {
-        .mode = bme280_mode_sleep,
-        .osr_temp = bme280_osr_temp_x1,
-        .osr_pres = bme280_osr_pres_x1,
-        .osr_hum = bme280_osr_hum_x1,
-        .standby = bme280_standbytime_1000s,
-        .filter = bme280_filter_off,
-    };
-    uint8_t reg_data[1];
-    bme280GetReg(device->spi_device, bme280_id_addr, reg_data, 1);
-    if (reg_data[0] & bme280_chip_id) {
-        bme280Reset(device);
-        bme280SetDeviceSettings(device, &settings);
-        bme280ReadCalibData(device->spi_device, &device->calib_data);
+    device->ready_time = 0;
+    struct bme280_cache_entry_t* entry = NULL;
+    uint8_t fingerprint[BME280_FINGERPRINT_SIZE];
+    uint8_t chip_id;
+    uint8_t status = bme280_status_update;
+    if (cache == NULL) {
+        bme280GetReg(device->spi_device, bme280_id_addr, &chip_id, 1);
+    } else {
+        bme280ReadFingerprint(device->spi_device, &chip_id, &status,
+                              fingerprint);
+        entry = bme280CacheFind(cache, device->spi_device);
+    }
+    if (!(chip_id & bme280_chip_id)) {
+        return -1;
+    }
+    // A matching fingerprint on an idle device means the NVM copy is done
+    // and the calibration is the one we cached, so skip the reset and read
+    if (entry != NULL && entry->chip_id == chip_id &&
+        !(status & bme280_status_update) &&
+        memcmp(entry->calib_reg, fingerprint, BME280_FINGERPRINT_SIZE) == 0) {
+        bme280Configure(device, entry->calib_reg);
+        *ready_time = clockGetTime();
+        return 1;
     }
+    bme280SetReg(device->spi_device, bme280_reset_addr, bme280_reset_command);
+    *ready_time = clockGetTime() + bme280_reset_time;
+    return 0;
+}
+
+int8_t bme280FinishInitialize(struct bme280_t* device,
+                              struct bme280_cache_t* cache) {
+    uint8_t calib_reg[BME280_CALIB_REG_SIZE];
+    uint8_t fingerprint[BME280_FINGERPRINT_SIZE];
+    uint8_t chip_id;
+    uint8_t status;
+    bme280ReadFingerprint(device->spi_device, &chip_id, &status, fingerprint);
+    if (status & bme280_status_update) {
+        return -1;
+    }
+    bme280ReadCalibReg(device->spi_device, calib_reg);
+    bme280Configure(device, calib_reg);
+    if (cache != NULL) {
+        bme280CacheStore(cache, bme280CacheFind(cache, device->spi_device),
+                         device->spi_device, chip_id, calib_reg);
+    }
+    return 0;
 }
 
 void bme280SetDeviceSettings(struct bme280_t* device,
@@ -85,20 +163,118 @@ void bme280SetDeviceSettings(struct bme280_t* device,
     bme280SetSettingsReg(device);
 }
 
+#ifdef BME280_FLOAT_ENABLE
+
+void bme280PrepareCompensation(struct bme280_t* device) {
+    struct bme280_calib_data_t* calib = &device->calib_data;
+    struct bme280_compensation_t* comp = &device->compensation;
+    comp->dig_t1_div1024 = ((double)calib->dig_t1) / 1024.0;
+    comp->dig_t1_div8192 = ((double)calib->dig_t1) / 8192.0;
+    comp->dig_t2 = (double)calib->dig_t2;
+    comp->dig_t3 = (double)calib->dig_t3;
+    comp->dig_p1 = (double)calib->dig_p1;
+    comp->dig_p2 = (double)calib->dig_p2;
+    comp->dig_p3 = (double)calib->dig_p3;
+    comp->dig_p4_x65536 = ((double)calib->dig_p4) * 65536.0;
+    comp->dig_p5 = (double)calib->dig_p5;
+    comp->dig_p6 = (double)calib->dig_p6;
+    comp->dig_p7 = (double)calib->dig_p7;
+    comp->dig_p8 = (double)calib->dig_p8;
+    comp->dig_p9 = (double)calib->dig_p9;
+    comp->dig_h1 = (double)calib->dig_h1;
+    comp->dig_h2_div65536 = ((double)calib->dig_h2) / 65536.0;
+    comp->dig_h3_div67108864 = ((double)calib->dig_h3) / 67108864.0;
+    comp->dig_h4_x64 = ((double)calib->dig_h4) * 64.0;
+    comp->dig_h5_div16384 = ((double)calib->dig_h5) / 16384.0;
+    comp->dig_h6_div67108864 = ((double)calib->dig_h6) / 67108864.0;
+}
+
+#else
+
+void bme280PrepareCompensation(struct bme280_t* device) {
+    struct bme280_calib_data_t* calib = &device->calib_data;
+    struct bme280_compensation_t* comp = &device->compensation;
+    comp->dig_t1 = (int32_t)calib->dig_t1;
+    comp->dig_t1_x2 = (int32_t)calib->dig_t1 * 2;
+    comp->dig_t2 = (int32_t)calib->dig_t2;
+    comp->dig_t3 = (int32_t)calib->dig_t3;
+    comp->dig_p4_x65536 = (int32_t)calib->dig_p4 * 65536;
+    comp->dig_h4_x1048576 = (int32_t)calib->dig_h4 * 1048576;
+    comp->dig_p1 = calib->dig_p1;
+    comp->dig_p2 = calib->dig_p2;
+    comp->dig_p3 = calib->dig_p3;
+    comp->dig_p5 = calib->dig_p5;
+    comp->dig_p6 = calib->dig_p6;
+    comp->dig_p7 = calib->dig_p7;
+    comp->dig_p8 = calib->dig_p8;
+    comp->dig_p9 = calib->dig_p9;
+    comp->dig_h2 = calib->dig_h2;
+    comp->dig_h5 = calib->dig_h5;
+    comp->dig_h1 = calib->dig_h1;
+    comp->dig_h3 = calib->dig_h3;
+    comp->dig_h6 = calib->dig_h6;
+}
+
+#endif
+
 void bme280ReadDeviceData(struct bme280_t* device, struct bme280_data_t* data) {
-    uint8_t data_reg[8];
-    uint8_t status[1];
+    uint64_t ready_time = bme280StartConversion(device);
+    INSTRUMENT_START(start);
+    clockSleepUntil(ready_time);
+    INSTRUMENT_DELAY(instrument_interface_spi, device->spi_device, start);
+    while (bme280FetchDeviceData(device, data) != 0) {
+        INSTRUMENT_POLL(instrument_interface_spi, device->spi_device);
+        delay(device->spi_device, 1);
+    }
+}
+
+uint32_t bme280GetMeasurementTime(struct bme280_t* device) {
+    uint32_t osr_temp = bme280_osr[device->settings.osr_temp >> 5];
+    uint32_t osr_pres = bme280_osr[device->settings.osr_pres >> 2];
+    uint32_t osr_hum = bme280_osr[device->settings.osr_hum];
+    uint32_t measurement_time = 1250 + 2300 * osr_temp;
+    if (osr_pres) {
+        measurement_time += 2300 * osr_pres + 575;
+    }
+    if (osr_hum) {
+        measurement_time += 2300 * osr_hum + 575;
+    }
+    return measurement_time;
+}
+
+uint64_t bme280StartConversion(struct bme280_t* device) {
+    device->ready_time = clockGetTime();
+    if (device->settings.mode == bme280_mode_forced) {
+        bme280SetReg(device->spi_device, bme280_ctrl_meas_addr,
+                     device->settings.osr_temp | device->settings.osr_pres |
+                         device->settings.mode);
+        device->ready_time += (uint64_t)bme280GetMeasurementTime(device) * 1000;
+    }
+    return device->ready_time;
+}
+
+uint64_t bme280GetReadyTime(struct bme280_t* device) {
+    return device->ready_time;
+}
+
+int8_t bme280FetchDeviceData(struct bme280_t* device,
+                             struct bme280_data_t* data) {
+    uint8_t status_reg[12];
+    bme280GetReg(device->spi_device, bme280_status_addr, status_reg, 12);
+    if (device->settings.mode == bme280_mode_forced &&
+        (status_reg[0] & bme280_status_measuring)) {
+        return -1;
+    }
+    bme280DecodeDeviceData(&status_reg[bme280_data_addr - bme280_status_addr],
+                           data);
+    return 0;
+}
+
+void bme280DecodeDeviceData(uint8_t const* data_reg,
+                            struct bme280_data_t* data) {
     uint32_t data_xlsb;
     uint32_t data_lsb;
     uint32_t data_msb;
-    if (device->settings.mode == bme280_mode_forced) {
-        bme280SetSettingsReg(device);
-    }
-    do {
-        delay(2);
-        bme280GetReg(device->spi_device, bme280_status_addr, status, 1);
-    } while (status[0] & bme280_status_measuring);
-    bme280GetReg(device->spi_device, bme280_data_addr, data_reg, 8);
     data_msb = data_reg[0] << 12;
     data_lsb = data_reg[1] << 4;
     data_xlsb = (data_reg[2] & 0xF0) >> 4;
@@ -114,18 +290,17 @@ void bme280ReadDeviceData(struct bme280_t* device, struct bme280_data_t* data) {
 
 #ifdef BME280_FLOAT_ENABLE
 
-double bme280CalculateTemperature(struct bme280_t* device,
-                                  struct bme280_data_t* data) {
+static double bme280CompensateTemperature(
+    struct bme280_compensation_t const* comp, struct bme280_data_t const* data,
+    int32_t* t_fine) {
     double var1;
     double var2;
     double temperature;
-    var1 = ((double)data->temperature) / 16384.0 -
-           ((double)device->calib_data.dig_t1) / 1024.0;
-    var1 = var1 * ((double)device->calib_data.dig_t2);
-    var2 = (((double)data->temperature) / 131072.0 -
-            ((double)device->calib_data.dig_t1) / 8192.0);
-    var2 = (var2 * var2) * ((double)device->calib_data.dig_t3);
-    device->calib_data.t_fine = var1 + var2;
+    var1 = ((double)data->temperature) / 16384.0 - comp->dig_t1_div1024;
+    var1 = var1 * comp->dig_t2;
+    var2 = (((double)data->temperature) / 131072.0 - comp->dig_t1_div8192);
+    var2 = (var2 * var2) * comp->dig_t3;
+    *t_fine = var1 + var2;
     temperature = (var1 + var2) / 5120.0;
     if (temperature > bme280_temperature_max) {
         temperature = bme280_temperature_max;
@@ -135,27 +310,26 @@ double bme280CalculateTemperature(struct bme280_t* device,
     return temperature;
 }
 
-double bme280CalculatePressure(struct bme280_t* device,
-                               struct bme280_data_t* data) {
+static double bme280CompensatePressure(
+    struct bme280_compensation_t const* comp, struct bme280_data_t const* data,
+    int32_t t_fine) {
     double var1;
     double var2;
     double var3;
     double pressure;
-    var1 = ((double)device->calib_data.t_fine / 2.0) - 64000.0;
-    var2 = var1 * var1 * ((double)device->calib_data.dig_p6) / 32768.0;
-    var2 = var2 + var1 * ((double)device->calib_data.dig_p5) * 2.0;
-    var2 = (var2 / 4.0) + (((double)device->calib_data.dig_p4) * 65536.0);
-    var3 = ((double)device->calib_data.dig_p3) * var1 * var1 / 524288.0;
-    var1 = (var3 + ((double)device->calib_data.dig_p2) * var1) / 524288.0;
-    var1 = (1.0 + var1 / 32768.0) * ((double)device->calib_data.dig_p1);
+    var1 = ((double)t_fine / 2.0) - 64000.0;
+    var2 = var1 * var1 * comp->dig_p6 / 32768.0;
+    var2 = var2 + var1 * comp->dig_p5 * 2.0;
+    var2 = (var2 / 4.0) + comp->dig_p4_x65536;
+    var3 = comp->dig_p3 * var1 * var1 / 524288.0;
+    var1 = (var3 + comp->dig_p2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * comp->dig_p1;
     if (var1 > 0.0) {
         pressure = 1048576.0 - (double)data->pressure;
         pressure = (pressure - (var2 / 4096.0)) * 6250.0 / var1;
-        var1 = ((double)device->calib_data.dig_p9) * pressure * pressure /
-               2147483648.0;
-        var2 = pressure * ((double)device->calib_data.dig_p8) / 32768.0;
-        pressure = pressure +
-                   (var1 + var2 + ((double)device->calib_data.dig_p7)) / 16.0;
+        var1 = comp->dig_p9 * pressure * pressure / 2147483648.0;
+        var2 = pressure * comp->dig_p8 / 32768.0;
+        pressure = pressure + (var1 + var2 + comp->dig_p7) / 16.0;
         pressure /= 100.0;
         if (pressure > bme280_pressure_max) {
             pressure = bme280_pressure_max;
@@ -168,8 +342,9 @@ double bme280CalculatePressure(struct bme280_t* device,
     return pressure;
 }
 
-double bme280CalculateHumidity(struct bme280_t* device,
-                               struct bme280_data_t* data) {
+static double bme280CompensateHumidity(
+    struct bme280_compensation_t const* comp, struct bme280_data_t const* data,
+    int32_t t_fine) {
     double var1;
     double var2;
     double var3;
@@ -177,17 +352,14 @@ double bme280CalculateHumidity(struct bme280_t* device,
     double var5;
     double var6;
     double humidity;
-    var1 = ((double)device->calib_data.t_fine) - 76800.0;
-    var2 = (((double)device->calib_data.dig_h4) * 64.0 +
-            (((double)device->calib_data.dig_h5) / 16384.0) * var1);
+    var1 = ((double)t_fine) - 76800.0;
+    var2 = (comp->dig_h4_x64 + comp->dig_h5_div16384 * var1);
     var3 = data->humidity - var2;
-    var4 = ((double)device->calib_data.dig_h2) / 65536.0;
-    var5 = (1.0 + (((double)device->calib_data.dig_h3) / 67108864.0) * var1);
-    var6 =
-        1.0 + (((double)device->calib_data.dig_h6) / 67108864.0) * var1 * var5;
+    var4 = comp->dig_h2_div65536;
+    var5 = (1.0 + comp->dig_h3_div67108864 * var1);
+    var6 = 1.0 + comp->dig_h6_div67108864 * var1 * var5;
     var6 = var3 * var4 * (var5 * var6);
-    humidity =
-        var6 * (1.0 - ((double)device->calib_data.dig_h1) * var6 / 524288.0);
+    humidity = var6 * (1.0 - comp->dig_h1 * var6 / 524288.0);
     if (humidity > bme280_humidity_max) {
         humidity = bme280_humidity_max;
     } else if (humidity < bme280_humidity_min) {
@@ -196,47 +368,77 @@ double bme280CalculateHumidity(struct bme280_t* device,
     return humidity;
 }
 
+double bme280CalculateTemperature(struct bme280_t* device,
+                                  struct bme280_data_t* data) {
+    return bme280CompensateTemperature(&device->compensation, data,
+                                       &device->calib_data.t_fine);
+}
+
+double bme280CalculatePressure(struct bme280_t* device,
+                               struct bme280_data_t* data) {
+    return bme280CompensatePressure(&device->compensation, data,
+                                    device->calib_data.t_fine);
+}
+
+double bme280CalculateHumidity(struct bme280_t* device,
+                               struct bme280_data_t* data) {
+    return bme280CompensateHumidity(&device->compensation, data,
+                                    device->calib_data.t_fine);
+}
+
+void bme280Compensate(struct bme280_compensation_t const* compensation,
+                      struct bme280_data_t const* data,
+                      struct bme280_measurement_t* measurement) {
+    int32_t t_fine;
+    measurement->temperature =
+        bme280CompensateTemperature(compensation, data, &t_fine);
+    measurement->pressure =
+        bme280CompensatePressure(compensation, data, t_fine);
+    measurement->humidity =
+        bme280CompensateHumidity(compensation, data, t_fine);
+}
+
 #else
 
-int32_t bme280CalculateTemperature(struct bme280_t* device,
-                                   struct bme280_data_t* data) {
+static int32_t bme280CompensateTemperature(
+    struct bme280_compensation_t const* comp, struct bme280_data_t const* data,
+    int32_t* t_fine) {
     int32_t var1;
     int32_t var2;
     int32_t temperature;
-    var1 = (int32_t)((data->temperature / 8) -
-                     ((int32_t)device->calib_data.dig_t1 * 2));
-    var1 = (var1 * ((int32_t)device->calib_data.dig_t2)) / 2048;
-    var2 = (int32_t)((data->temperature / 16) -
-                     ((int32_t)device->calib_data.dig_t1));
-    var2 =
-        (((var2 * var2) / 4096) * ((int32_t)device->calib_data.dig_t3)) / 16384;
-    device->calib_data.t_fine = var1 + var2;
-    temperature = (device->calib_data.t_fine * 5 + 128) / 256;
+    var1 = (int32_t)((data->temperature / 8) - comp->dig_t1_x2);
+    var1 = (var1 * comp->dig_t2) / 2048;
+    var2 = (int32_t)((data->temperature / 16) - comp->dig_t1);
+    var2 = (((var2 * var2) / 4096) * comp->dig_t3) / 16384;
+    *t_fine = var1 + var2;
+    temperature = (*t_fine * 5 + 128) / 256;
     if (temperature > bme280_temperature_max) {
         temperature = bme280_temperature_max;
+        *t_fine = bme280_t_fine_max;
     } else if (temperature < bme280_temperature_min) {
         temperature = bme280_temperature_min;
+        *t_fine = bme280_t_fine_min;
     }
     return temperature;
 }
 
-uint32_t bme280CalculatePressure(struct bme280_t* device,
-                                 struct bme280_data_t* data) {
+static uint32_t bme280CompensatePressure(
+    struct bme280_compensation_t const* comp, struct bme280_data_t const* data,
+    int32_t t_fine) {
     int32_t var1;
     int32_t var2;
     int32_t var3;
     int32_t var4;
     uint32_t var5;
     uint32_t pressure;
-    var1 = (((int32_t)device->calib_data.t_fine) / 2) - (int32_t)64000;
-    var2 = (((var1 / 4) * (var1 / 4)) / 2048) *
-           ((int32_t)device->calib_data.dig_p6);
-    var2 = var2 + ((var1 * ((int32_t)device->calib_data.dig_p5)) * 2);
-    var2 = (var2 / 4) + (((int32_t)device->calib_data.dig_p4) * 65536);
-    var3 = (device->calib_data.dig_p3 * (((var1 / 4) * (var1 / 4)) / 8192)) / 8;
-    var4 = (((int32_t)device->calib_data.dig_p2) * var1) / 2;
+    var1 = (t_fine / 2) - (int32_t)64000;
+    var2 = (((var1 / 4) * (var1 / 4)) / 2048) * comp->dig_p6;
+    var2 = var2 + ((var1 * comp->dig_p5) * 2);
+    var2 = (var2 / 4) + comp->dig_p4_x65536;
+    var3 = (comp->dig_p3 * (((var1 / 4) * (var1 / 4)) / 8192)) / 8;
+    var4 = (comp->dig_p2 * var1) / 2;
     var1 = (var3 + var4) / 262144;
-    var1 = (((32768 + var1)) * ((int32_t)device->calib_data.dig_p1)) / 32768;
+    var1 = (((32768 + var1)) * comp->dig_p1) / 32768;
     if (var1) {
         var5 = (uint32_t)((uint32_t)1048576) - data->pressure;
         pressure = ((uint32_t)(var5 - (uint32_t)(var2 / 4096))) * 3125;
@@ -245,14 +447,12 @@ uint32_t bme280CalculatePressure(struct bme280_t* device,
         } else {
             pressure = (pressure / (uint32_t)var1) * 2;
         }
-        var1 = (((int32_t)device->calib_data.dig_p9) *
+        var1 = (comp->dig_p9 *
                 ((int32_t)(((pressure / 8) * (pressure / 8)) / 8192))) /
                4096;
-        var2 =
-            (((int32_t)(pressure / 4)) * ((int32_t)device->calib_data.dig_p8)) /
-            8192;
+        var2 = (((int32_t)(pressure / 4)) * comp->dig_p8) / 8192;
         pressure = (uint32_t)((int32_t)pressure +
-                              ((var1 + var2 + device->calib_data.dig_p7) / 16));
+                              ((var1 + var2 + comp->dig_p7) / 16));
         if (pressure > bme280_pressure_max) {
             pressure = bme280_pressure_max;
         } else if (pressure < bme280_pressure_min) {
@@ -264,26 +464,27 @@ uint32_t bme280CalculatePressure(struct bme280_t* device,
     return pressure;
 }
 
-uint32_t bme280CalculateHumidity(struct bme280_t* device,
-                                 struct bme280_data_t* data) {
+static uint32_t bme280CompensateHumidity(
+    struct bme280_compensation_t const* comp, struct bme280_data_t const* data,
+    int32_t t_fine) {
     int32_t var1;
     int32_t var2;
     int32_t var3;
     int32_t var4;
     int32_t var5;
     uint32_t humidity;
-    var1 = device->calib_data.t_fine - ((int32_t)76800);
+    var1 = t_fine - ((int32_t)76800);
     var2 = (int32_t)(data->humidity * 16384);
-    var3 = (int32_t)(((int32_t)device->calib_data.dig_h4) * 1048576);
-    var4 = ((int32_t)device->calib_data.dig_h5) * var1;
+    var3 = comp->dig_h4_x1048576;
+    var4 = comp->dig_h5 * var1;
     var5 = (((var2 - var3) - var4) + (int32_t)16384) / 32768;
-    var2 = (var1 * ((int32_t)device->calib_data.dig_h6)) / 1024;
-    var3 = (var1 * ((int32_t)device->calib_data.dig_h3)) / 2048;
+    var2 = (var1 * comp->dig_h6) / 1024;
+    var3 = (var1 * comp->dig_h3) / 2048;
     var4 = ((var2 * (var3 + (int32_t)32768)) / 1024) + (int32_t)2097152;
-    var2 = ((var4 * ((int32_t)device->calib_data.dig_h2)) + 8192) / 16384;
+    var2 = ((var4 * comp->dig_h2) + 8192) / 16384;
     var3 = var5 * var2;
     var4 = ((var3 / 32768) * (var3 / 32768)) / 128;
-    var5 = var3 - ((var4 * ((int32_t)device->calib_data.dig_h1)) / 16);
+    var5 = var3 - ((var4 * comp->dig_h1) / 16);
     var5 = (var5 < 0 ? 0 : var5);
     var5 = (var5 > 419430400 ? 419430400 : var5);
     humidity = (uint32_t)(var5 / 4096);
@@ -293,18 +494,163 @@ uint32_t bme280CalculateHumidity(struct bme280_t* device,
     return humidity;
 }
 
+int32_t bme280CalculateTemperature(struct bme280_t* device,
+                                   struct bme280_data_t* data) {
+    return bme280CompensateTemperature(&device->compensation, data,
+                                       &device->calib_data.t_fine);
+}
+
+uint32_t bme280CalculatePressure(struct bme280_t* device,
+                                 struct bme280_data_t* data) {
+    return bme280CompensatePressure(&device->compensation, data,
+                                    device->calib_data.t_fine);
+}
+
+uint32_t bme280CalculateHumidity(struct bme280_t* device,
+                                 struct bme280_data_t* data) {
+    return bme280CompensateHumidity(&device->compensation, data,
+                                    device->calib_data.t_fine);
+}
+
+void bme280Compensate(struct bme280_compensation_t const* compensation,
+                      struct bme280_data_t const* data,
+                      struct bme280_measurement_t* measurement) {
+    int32_t t_fine;
+    measurement->temperature =
+        bme280CompensateTemperature(compensation, data, &t_fine);
+    measurement->pressure =
+        bme280CompensatePressure(compensation, data, t_fine);
+    measurement->humidity =
+        bme280CompensateHumidity(compensation, data, t_fine);
+}
+
 #endif
 
-static void bme280ReadCalibData(spi_device_t spi_device,
-                                struct bme280_calib_data_t* data) {
-    uint8_t reg_data[32];
+void bme280CacheInitialize(struct bme280_cache_t* cache) {
+    cache->count = 0;
+    cache->modified = 0;
+}
+
+int8_t bme280CacheLoad(struct bme280_cache_t* cache, char const* path) {
+    char magic[sizeof(bme280_cache_magic)];
+    bme280CacheInitialize(cache);
+    FILE* stream = fopen(path, "rb");
+    if (stream == NULL) {
+        return -1;
+    }
+    if (fread(magic, sizeof(magic), 1, stream) != 1 ||
+        memcmp(magic, bme280_cache_magic, sizeof(magic)) != 0) {
+        fclose(stream);
+        return -1;
+    }
+    while (cache->count < BME280_CACHE_MAX &&
+           fread(&cache->entries[cache->count],
+                 sizeof(struct bme280_cache_entry_t), 1, stream) == 1) {
+        cache->count++;
+    }
+    fclose(stream);
+    return 0;
+}
+
+int8_t bme280CacheSave(struct bme280_cache_t* cache, char const* path) {
+    FILE* stream = fopen(path, "wb");
+    if (stream == NULL) {
+        return -1;
+    }
+    size_t written = fwrite(bme280_cache_magic, sizeof(bme280_cache_magic),
+                            1, stream);
+    written += fwrite(cache->entries, sizeof(struct bme280_cache_entry_t),
+                      cache->count, stream);
+    if (fclose(stream) != 0 || written != cache->count + 1) {
+        return -1;
+    }
+    cache->modified = 0;
+    return 0;
+}
+
+void bme280CacheMerge(struct bme280_cache_t* cache,
+                      struct bme280_cache_t const* source) {
+    for (uint32_t i = 0; i < source->count; i++) {
+        struct bme280_cache_entry_t const* from = &source->entries[i];
+        struct bme280_cache_entry_t* entry = NULL;
+        for (uint32_t j = 0; j < cache->count && entry == NULL; j++) {
+            if (cache->entries[j].bus_number == from->bus_number &&
+                cache->entries[j].slave_number == from->slave_number) {
+                entry = &cache->entries[j];
+            }
+        }
+        if (entry == NULL) {
+            if (cache->count >= BME280_CACHE_MAX) {
+                continue;
+            }
+            entry = &cache->entries[cache->count++];
+        } else if (memcmp(entry, from, sizeof(*entry)) == 0) {
+            continue;
+        }
+        *entry = *from;
+        cache->modified = 1;
+    }
+}
+
+static struct bme280_cache_entry_t* bme280CacheFind(
+    struct bme280_cache_t* cache, spi_device_t spi_device) {
+    uint8_t bus_number = spiGetBusNumber(spi_device);
+    uint8_t slave_number = spiGetSlaveNumber(spi_device);
+    for (uint32_t i = 0; i < cache->count; i++) {
+        if (cache->entries[i].bus_number == bus_number &&
+            cache->entries[i].slave_number == slave_number) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void bme280CacheStore(struct bme280_cache_t* cache,
+                             struct bme280_cache_entry_t* entry,
+                             spi_device_t spi_device, uint8_t chip_id,
+                             uint8_t const* calib_reg) {
+    if (entry == NULL) {
+        if (cache->count >= BME280_CACHE_MAX) {
+            return;
+        }
+        entry = &cache->entries[cache->count++];
+    }
+    entry->bus_number = spiGetBusNumber(spi_device);
+    entry->slave_number = spiGetSlaveNumber(spi_device);
+    entry->chip_id = chip_id;
+    memcpy(entry->calib_reg, calib_reg, BME280_CALIB_REG_SIZE);
+    cache->modified = 1;
+}
+
+static void bme280ReadCalibReg(spi_device_t spi_device, uint8_t* reg_data) {
+    uint8_t tx_buf[35];
+    uint8_t rx_buf[35];
+    struct spi_segment_t segments[3] = {
+        {.tx_buffer = &tx_buf[0], .rx_buffer = &rx_buf[0], .length = 25,
+         .cs_change = 1},
+        {.tx_buffer = &tx_buf[25], .rx_buffer = &rx_buf[25], .length = 2,
+         .cs_change = 1},
+        {.tx_buffer = &tx_buf[27], .rx_buffer = &rx_buf[27], .length = 8,
+         .cs_change = 1},
+    };
+    for (uint8_t i = 0; i < sizeof(tx_buf); i++) {
+        tx_buf[i] = 0x00;
+    }
+    tx_buf[0] = bme280_temp_pres_calib_data_addr | 0x80;
+    tx_buf[25] = bme280_hum1_calib_data_addr | 0x80;
+    tx_buf[27] = bme280_hum_calib_data_addr | 0x80;
+    spiTransferBatch(spi_device, segments, 3);
+    memcpy(&reg_data[0], &rx_buf[1], 24);
+    reg_data[24] = rx_buf[26];
+    memcpy(&reg_data[25], &rx_buf[28], 7);
+}
+
+static void bme280DecodeCalibData(uint8_t const* reg_data,
+                                  struct bme280_calib_data_t* data) {
     uint16_t dig_h4_lsb;
     uint16_t dig_h4_msb;
     uint16_t dig_h5_lsb;
     uint16_t dig_h5_msb;
-    bme280GetReg(spi_device, bme280_temp_pres_calib_data_addr, reg_data, 24);
-    bme280GetReg(spi_device, bme280_hum1_calib_data_addr, &reg_data[24], 1);
-    bme280GetReg(spi_device, bme280_hum_calib_data_addr, &reg_data[25], 7);
     data->dig_t1 = reg_data[1] << 8 | reg_data[0];
     data->dig_t2 = (int16_t)(reg_data[3] << 8 | reg_data[2]);
     data->dig_t3 = (int16_t)(reg_data[5] << 8 | reg_data[4]);
@@ -329,23 +675,55 @@ static void bme280ReadCalibData(spi_device_t spi_device,
     data->dig_h6 = (int8_t)reg_data[31];
 }
 
-static void bme280Reset(struct bme280_t* device) {
-    bme280SetReg(device->spi_device, bme280_reset_addr, bme280_reset_command);
-    uint8_t status[1];
-    do {
-        delay(2);
-        bme280GetReg(device->spi_device, bme280_status_addr, status, 1);
-    } while (status[0] & bme280_status_update);
+static void bme280ReadFingerprint(spi_device_t spi_device, uint8_t* chip_id,
+                                  uint8_t* status, uint8_t* fingerprint) {
+    uint8_t tx_buf[4 + BME280_FINGERPRINT_SIZE + 1];
+    uint8_t rx_buf[4 + BME280_FINGERPRINT_SIZE + 1];
+    struct spi_segment_t segments[3] = {
+        {.tx_buffer = &tx_buf[0], .rx_buffer = &rx_buf[0], .length = 2,
+         .cs_change = 1},
+        {.tx_buffer = &tx_buf[2], .rx_buffer = &rx_buf[2], .length = 2,
+         .cs_change = 1},
+        {.tx_buffer = &tx_buf[4], .rx_buffer = &rx_buf[4],
+         .length = BME280_FINGERPRINT_SIZE + 1, .cs_change = 1},
+    };
+    for (uint8_t i = 0; i < sizeof(tx_buf); i++) {
+        tx_buf[i] = 0x00;
+    }
+    tx_buf[0] = bme280_id_addr | 0x80;
+    tx_buf[2] = bme280_status_addr | 0x80;
+    tx_buf[4] = bme280_temp_pres_calib_data_addr | 0x80;
+    spiTransferBatch(spi_device, segments, 3);
+    *chip_id = rx_buf[1];
+    *status = rx_buf[3];
+    memcpy(fingerprint, &rx_buf[5], BME280_FINGERPRINT_SIZE);
+}
+
+static void bme280Configure(struct bme280_t* device,
+                            uint8_t const* calib_reg) {
+    struct bme280_settings_t settings = {
+        .mode = bme280_mode_sleep,
+        .osr_temp = bme280_osr_temp_x1,
+        .osr_pres = bme280_osr_pres_x1,
+        .osr_hum = bme280_osr_hum_x1,
+        .standby = bme280_standbytime_1000s,
+        .filter = bme280_filter_off,
+    };
+    bme280SetDeviceSettings(device, &settings);
+    bme280DecodeCalibData(calib_reg, &device->calib_data);
+    bme280PrepareCompensation(device);
 }
 
 static void bme280SetSettingsReg(struct bme280_t* device) {
-    uint8_t config_reg = device->settings.standby | device->settings.filter;
-    uint8_t ctrl_meas_reg = device->settings.osr_temp |
-                            device->settings.osr_pres | device->settings.mode;
-    uint8_t ctrl_hum_reg = device->settings.osr_hum;
-    bme280SetReg(device->spi_device, bme280_config_addr, config_reg);
-    bme280SetReg(device->spi_device, bme280_ctrl_meas_addr, ctrl_meas_reg);
-    bme280SetReg(device->spi_device, bme280_ctrl_hum_addr, ctrl_hum_reg);
+    uint8_t buf[6];
+    buf[0] = bme280_ctrl_hum_addr & 0x7F;
+    buf[1] = device->settings.osr_hum;
+    buf[2] = bme280_config_addr & 0x7F;
+    buf[3] = device->settings.standby | device->settings.filter;
+    buf[4] = bme280_ctrl_meas_addr & 0x7F;
+    buf[5] = device->settings.osr_temp | device->settings.osr_pres |
+             device->settings.mode;
+    spiTransfer(device->spi_device, buf, NULL, 6);
 }
 
 static void bme280SetReg(spi_device_t device, uint8_t address, uint8_t data) {
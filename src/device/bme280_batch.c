@@ -0,0 +1,191 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "device/bme280.h"
+
+#ifdef BME280_FLOAT_ENABLE
+
+void bme280CompensateBatch(struct bme280_t* device,
+                           uint32_t const* raw_temperature,
+                           uint32_t const* raw_pressure,
+                           uint32_t const* raw_humidity, double* temperature,
+                           double* pressure, double* humidity,
+                           uint32_t count) {
+    struct bme280_data_t data;
+    struct bme280_measurement_t measurement;
+    for (uint32_t i = 0; i < count; i++) {
+        data.temperature = raw_temperature[i];
+        data.pressure = raw_pressure[i];
+        data.humidity = raw_humidity[i];
+        bme280Compensate(&device->compensation, &data, &measurement);
+        temperature[i] = measurement.temperature;
+        pressure[i] = measurement.pressure;
+        humidity[i] = measurement.humidity;
+    }
+}
+
+#elif defined(__GNUC__)
+
+#define BME280_LANES 8
+#define BME280_CACHE_LINE 64
+
+typedef int32_t bme280_vector_t
+    __attribute__((vector_size(BME280_LANES * sizeof(int32_t))));
+typedef uint32_t bme280_uvector_t
+    __attribute__((vector_size(BME280_LANES * sizeof(uint32_t))));
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BME280_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define BME280_TARGET_CLONES
+#endif
+
+#define BME280_SELECT(mask, a, b) (((a) & (mask)) | ((b) & ~(mask)))
+
+BME280_TARGET_CLONES
+static void bme280CompensateVector(struct bme280_compensation_t const* comp,
+                                   uint32_t const* raw_temperature,
+                                   uint32_t const* raw_pressure,
+                                   uint32_t const* raw_humidity,
+                                   int32_t* temperature, uint32_t* pressure,
+                                   uint32_t* humidity) {
+    bme280_uvector_t adc_t;
+    bme280_uvector_t adc_p;
+    bme280_uvector_t adc_h;
+    bme280_vector_t var1;
+    bme280_vector_t var2;
+    bme280_vector_t var3;
+    bme280_vector_t var4;
+    bme280_vector_t var5;
+    bme280_vector_t t_fine;
+    bme280_vector_t result;
+    bme280_vector_t mask;
+    bme280_uvector_t uvar5;
+    bme280_uvector_t p;
+    bme280_uvector_t divisor;
+    bme280_vector_t const zero = {0};
+    memcpy(&adc_t, raw_temperature, sizeof(adc_t));
+    memcpy(&adc_p, raw_pressure, sizeof(adc_p));
+    memcpy(&adc_h, raw_humidity, sizeof(adc_h));
+
+    var1 = (bme280_vector_t)(adc_t / 8) - comp->dig_t1_x2;
+    var1 = (var1 * comp->dig_t2) / 2048;
+    var2 = (bme280_vector_t)(adc_t / 16) - comp->dig_t1;
+    var2 = (((var2 * var2) / 4096) * comp->dig_t3) / 16384;
+    t_fine = var1 + var2;
+    result = (t_fine * 5 + 128) / 256;
+    mask = result > 8500;
+    result = BME280_SELECT(mask, zero + 8500, result);
+    t_fine = BME280_SELECT(mask, zero + 435200, t_fine);
+    mask = result < -4000;
+    result = BME280_SELECT(mask, zero - 4000, result);
+    t_fine = BME280_SELECT(mask, zero - 204800, t_fine);
+    memcpy(temperature, &result, sizeof(result));
+
+    var1 = (t_fine / 2) - 64000;
+    var2 = (((var1 / 4) * (var1 / 4)) / 2048) * comp->dig_p6;
+    var2 = var2 + ((var1 * comp->dig_p5) * 2);
+    var2 = (var2 / 4) + comp->dig_p4_x65536;
+    var3 = (comp->dig_p3 * (((var1 / 4) * (var1 / 4)) / 8192)) / 8;
+    var4 = (comp->dig_p2 * var1) / 2;
+    var1 = (var3 + var4) / 262144;
+    var1 = ((32768 + var1) * comp->dig_p1) / 32768;
+    mask = var1 == 0;
+    uvar5 = 1048576 - adc_p;
+    p = (uvar5 - (bme280_uvector_t)(var2 / 4096)) * 3125;
+    divisor = (bme280_uvector_t)BME280_SELECT(mask, zero + 1, var1);
+    p = (bme280_uvector_t)BME280_SELECT(
+        (bme280_vector_t)(p < 0x80000000),
+        (bme280_vector_t)((p << 1) / divisor),
+        (bme280_vector_t)((p / divisor) * 2));
+    var1 = (comp->dig_p9 *
+            (bme280_vector_t)(((p / 8) * (p / 8)) / 8192)) /
+           4096;
+    var2 = ((bme280_vector_t)(p / 4) * comp->dig_p8) / 8192;
+    result = (bme280_vector_t)p + ((var1 + var2 + comp->dig_p7) / 16);
+    p = (bme280_uvector_t)result;
+    mask |= (bme280_vector_t)(p < 30000);
+    result = BME280_SELECT((bme280_vector_t)(p > 110000), zero + 110000,
+                           result);
+    result = BME280_SELECT(mask, zero + 30000, result);
+    memcpy(pressure, &result, sizeof(result));
+
+    var1 = t_fine - 76800;
+    var2 = (bme280_vector_t)(adc_h * 16384);
+    var3 = zero + comp->dig_h4_x1048576;
+    var4 = comp->dig_h5 * var1;
+    var5 = (((var2 - var3) - var4) + 16384) / 32768;
+    var2 = (var1 * comp->dig_h6) / 1024;
+    var3 = (var1 * comp->dig_h3) / 2048;
+    var4 = ((var2 * (var3 + 32768)) / 1024) + 2097152;
+    var2 = ((var4 * comp->dig_h2) + 8192) / 16384;
+    var3 = var5 * var2;
+    var4 = ((var3 / 32768) * (var3 / 32768)) / 128;
+    var5 = var3 - ((var4 * comp->dig_h1) / 16);
+    var5 = BME280_SELECT(var5 < 0, zero, var5);
+    var5 = BME280_SELECT(var5 > 419430400, zero + 419430400, var5);
+    result = var5 / 4096;
+    result = BME280_SELECT(result > 102400, zero + 102400, result);
+    memcpy(humidity, &result, sizeof(result));
+}
+
+void bme280CompensateBatch(struct bme280_t* device,
+                           uint32_t const* raw_temperature,
+                           uint32_t const* raw_pressure,
+                           uint32_t const* raw_humidity, int32_t* temperature,
+                           uint32_t* pressure, uint32_t* humidity,
+                           uint32_t count) {
+    // A local copy on its own cache line, without imposing that alignment
+    // on struct bme280_t
+    _Alignas(BME280_CACHE_LINE) struct bme280_compensation_t comp =
+        device->compensation;
+    uint32_t i = 0;
+    for (; i + BME280_LANES <= count; i += BME280_LANES) {
+        bme280CompensateVector(&comp, &raw_temperature[i], &raw_pressure[i],
+                               &raw_humidity[i], &temperature[i], &pressure[i],
+                               &humidity[i]);
+    }
+    if (i < count) {
+        uint32_t tail_temperature[BME280_LANES] = {0};
+        uint32_t tail_pressure[BME280_LANES] = {0};
+        uint32_t tail_humidity[BME280_LANES] = {0};
+        int32_t out_temperature[BME280_LANES];
+        uint32_t out_pressure[BME280_LANES];
+        uint32_t out_humidity[BME280_LANES];
+        uint32_t remain = count - i;
+        memcpy(tail_temperature, &raw_temperature[i],
+               remain * sizeof(uint32_t));
+        memcpy(tail_pressure, &raw_pressure[i], remain * sizeof(uint32_t));
+        memcpy(tail_humidity, &raw_humidity[i], remain * sizeof(uint32_t));
+        bme280CompensateVector(&comp, tail_temperature, tail_pressure,
+                               tail_humidity, out_temperature, out_pressure,
+                               out_humidity);
+        memcpy(&temperature[i], out_temperature, remain * sizeof(int32_t));
+        memcpy(&pressure[i], out_pressure, remain * sizeof(uint32_t));
+        memcpy(&humidity[i], out_humidity, remain * sizeof(uint32_t));
+    }
+}
+
+#else
+
+void bme280CompensateBatch(struct bme280_t* device,
+                           uint32_t const* raw_temperature,
+                           uint32_t const* raw_pressure,
+                           uint32_t const* raw_humidity, int32_t* temperature,
+                           uint32_t* pressure, uint32_t* humidity,
+                           uint32_t count) {
+    struct bme280_data_t data;
+    struct bme280_measurement_t measurement;
+    for (uint32_t i = 0; i < count; i++) {
+        data.temperature = raw_temperature[i];
+        data.pressure = raw_pressure[i];
+        data.humidity = raw_humidity[i];
+        bme280Compensate(&device->compensation, &data, &measurement);
+        temperature[i] = measurement.temperature;
+        pressure[i] = measurement.pressure;
+        humidity[i] = measurement.humidity;
+    }
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "device/bme280.h"
+#include "device/bme280_stream.h"
+#include "interface/spi.h"
+#include "utility/clock.h"
+
+static uint8_t const bme280_stream_status_addr = 0xF3;
+static uint8_t const bme280_stream_status_measuring = 0x08;
+
+static uint64_t const bme280_stream_standby_time = 500000;
+static uint64_t const bme280_stream_guard_time = 100000;
+static uint64_t const bme280_stream_retry_time = 100000;
+static uint64_t const bme280_stream_lock_time = 100000;
+
+static uint8_t bme280StreamGetStatus(struct bme280_stream_t* stream);
+
+int8_t bme280StreamStart(struct bme280_stream_t* stream,
+                         struct bme280_t* device,
+                         struct bme280_settings_t* settings) {
+    struct bme280_settings_t stream_settings = *settings;
+    uint64_t edge_time[2];
+    uint8_t edge_count = 0;
+    uint8_t measuring = 0;
+    memset(stream, 0, sizeof(struct bme280_stream_t));
+    stream->device = device;
+
+    // Free-run with the shortest standby, 0x00 is 0.5 ms
+    stream_settings.mode = bme280_mode_normal;
+    stream_settings.standby = bme280_standbytime_1s;
+    bme280SetDeviceSettings(device, &stream_settings);
+    stream->nominal_period = (uint64_t)bme280GetMeasurementTime(device) * 1000 +
+                             bme280_stream_standby_time;
+
+    // Lock onto the conversion cadence by timing two measuring bit edges
+    uint64_t deadline = clockGetTime() + 3 * stream->nominal_period;
+    while (edge_count < 2) {
+        uint8_t status = bme280StreamGetStatus(stream);
+        uint64_t now = clockGetTime();
+        if (measuring && !(status & bme280_stream_status_measuring)) {
+            edge_time[edge_count++] = now;
+        }
+        measuring = status & bme280_stream_status_measuring;
+        if (now >= deadline) {
+            return -1;
+        }
+        clockSleepUntil(now + bme280_stream_lock_time);
+    }
+    stream->period = edge_time[1] - edge_time[0];
+    stream->edge_time = edge_time[1];
+    stream->ready_time = edge_time[1];
+    stream->start_time = edge_time[1];
+    return 0;
+}
+
+void bme280StreamStop(struct bme280_stream_t* stream) {
+    struct bme280_settings_t settings = stream->device->settings;
+    settings.mode = bme280_mode_sleep;
+    bme280SetDeviceSettings(stream->device, &settings);
+}
+
+uint64_t bme280StreamGetReadyTime(struct bme280_stream_t* stream) {
+    return stream->ready_time;
+}
+
+int8_t bme280StreamFetch(struct bme280_stream_t* stream,
+                         struct bme280_data_t* data, uint64_t* timestamp) {
+    uint8_t tx_buf[13] = {bme280_stream_status_addr | 0x80};
+    uint8_t rx_buf[13];
+    uint64_t now = clockGetTime();
+    uint64_t edge = stream->edge_time;
+    uint64_t period = stream->period;
+
+    // Within half a period of the last sample nothing new can be there yet
+    if (stream->samples != 0 && now + period / 2 < edge) {
+        return -1;
+    }
+    spiTransfer(stream->device->spi_device, tx_buf, rx_buf, 13);
+    now = clockGetTime();
+    stream->transfers++;
+    uint8_t measuring = rx_buf[1] & bme280_stream_status_measuring;
+    uint8_t* data_reg = &rx_buf[5];
+    uint8_t changed = stream->samples == 0 ||
+                      memcmp(data_reg, stream->data_reg, 8) != 0;
+
+    // The registers only hold the latest sample, count any we slept through
+    if (now > edge + period) {
+        uint64_t skipped = (now - edge) / period;
+        stream->missed += skipped;
+        edge += skipped * period;
+        stream->early_time = 0;
+    }
+
+    // Conversion still running, the registers hold the previous sample
+    if (measuring && !changed) {
+        stream->duplicates++;
+        stream->early_time = now;
+        stream->ready_time = now + bme280_stream_retry_time;
+        return -1;
+    }
+
+    // Bound when this conversion ended and pull the schedule towards it
+    uint64_t lower = now - bme280_stream_standby_time;
+    uint64_t upper = now;
+    if (measuring) {
+        upper = lower;
+        lower = 0;
+    } else if (stream->early_time > lower) {
+        lower = stream->early_time;
+    }
+    uint64_t observed = edge < lower ? lower : edge > upper ? upper : edge;
+    int64_t error = (int64_t)(observed - edge);
+    edge += error / 2;
+    period += error / 8;
+    if (period < stream->nominal_period / 2 ||
+        period > stream->nominal_period * 2) {
+        period = stream->nominal_period;
+    }
+
+    bme280DecodeDeviceData(data_reg, data);
+    memcpy(stream->data_reg, data_reg, 8);
+    if (timestamp != NULL) {
+        *timestamp = edge;
+    }
+    stream->samples++;
+    stream->early_time = 0;
+    stream->period = period;
+    stream->edge_time = edge + period;
+    stream->ready_time = stream->edge_time + bme280_stream_guard_time;
+    return 0;
+}
+
+void bme280StreamRead(struct bme280_stream_t* stream,
+                      struct bme280_data_t* data, uint64_t* timestamp) {
+    do {
+        clockSleepUntil(stream->ready_time);
+    } while (bme280StreamFetch(stream, data, timestamp) != 0);
+}
+
+void bme280StreamGetStatistics(struct bme280_stream_t* stream,
+                               struct bme280_stream_statistics_t* statistics) {
+    uint64_t elapsed = clockGetTime() - stream->start_time;
+    statistics->rate = elapsed ? stream->samples * 1e9 / elapsed : 0.0;
+    statistics->period = stream->period;
+    statistics->samples = stream->samples;
+    statistics->duplicates = stream->duplicates;
+    statistics->missed = stream->missed;
+    statistics->transfers = stream->transfers;
+}
+
+static uint8_t bme280StreamGetStatus(struct bme280_stream_t* stream) {
+    uint8_t tx_buf[2] = {bme280_stream_status_addr | 0x80, 0x00};
+    uint8_t rx_buf[2];
+    spiTransfer(stream->device->spi_device, tx_buf, rx_buf, 2);
+    stream->transfers++;
+    return rx_buf[1];
+}
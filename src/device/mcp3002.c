@@ -3,12 +3,11 @@
 #include "device/mcp3002.h"
 #include "interface/spi.h"
 
-#include <unistd.h>
-void delay(uint16_t ms) {
-    usleep(ms * 1000);
-}
+static uint8_t const mcp3002_batch_max = 255;
 
 static uint16_t mcp3002GetReg(uint8_t device, enum mcp3002_channel_t channel);
+static void mcp3002GetRegs(uint8_t device, enum mcp3002_channel_t* channels,
+                           uint16_t* values, uint8_t count);
 
 void mcp3002Initialize(struct mcp3002_t* device, spi_device_t spi_device) {
     device->spi_device = spi_device;
@@ -25,15 +24,45 @@ void mcp3002SetDeviceSettings(struct mcp3002_t* device,
 
 void mcp3002ReadDeviceData(struct mcp3002_t* device,
                            struct mcp3002_data_t* data) {
-    delay(100);
-    data->differential_0 =
-        mcp3002GetReg(device->spi_device, mcp3002_channel_differential_0);
-    data->differential_1 =
-        mcp3002GetReg(device->spi_device, mcp3002_channel_differential_1);
-    data->single_0 =
-        mcp3002GetReg(device->spi_device, mcp3002_channel_single_0);
-    data->single_1 =
-        mcp3002GetReg(device->spi_device, mcp3002_channel_single_1);
+    uint16_t values[4];
+    mcp3002ReadChannels(device, mcp3002_channel_mask_all, 1, values);
+    data->differential_0 = values[0];
+    data->differential_1 = values[1];
+    data->single_0 = values[2];
+    data->single_1 = values[3];
+}
+
+uint16_t mcp3002ReadChannel(struct mcp3002_t* device,
+                            enum mcp3002_channel_t channel) {
+    return mcp3002GetReg(device->spi_device, channel);
+}
+
+void mcp3002ReadChannels(struct mcp3002_t* device, uint8_t channel_mask,
+                         uint16_t count, uint16_t* values) {
+    enum mcp3002_channel_t channels[mcp3002_batch_max];
+    uint8_t channel_count = 0;
+    uint32_t total;
+    uint32_t offset = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (channel_mask & (1 << i)) {
+            channels[channel_count++] = (enum mcp3002_channel_t)(i << 4);
+        }
+    }
+    if (channel_count == 0) {
+        return;
+    }
+    for (uint8_t i = channel_count; i < mcp3002_batch_max; i++) {
+        channels[i] = channels[i % channel_count];
+    }
+    total = (uint32_t)count * channel_count;
+    while (offset < total) {
+        uint8_t length = mcp3002_batch_max - mcp3002_batch_max % channel_count;
+        if (total - offset < length) {
+            length = total - offset;
+        }
+        mcp3002GetRegs(device->spi_device, channels, &values[offset], length);
+        offset += length;
+    }
 }
 
 #ifdef MCP3002_FLOAT_ENABLE
@@ -97,3 +126,22 @@ static uint16_t mcp3002GetReg(uint8_t device, enum mcp3002_channel_t channel) {
     data = (rx_buf[0] & 0x03) << 8 | rx_buf[1];
     return data;
 }
+
+static void mcp3002GetRegs(uint8_t device, enum mcp3002_channel_t* channels,
+                           uint16_t* values, uint8_t count) {
+    uint8_t tx_buf[count * 2];
+    uint8_t rx_buf[count * 2];
+    struct spi_segment_t segments[count];
+    for (uint8_t i = 0; i < count; i++) {
+        tx_buf[i * 2] = 0x48 | channels[i];
+        tx_buf[i * 2 + 1] = 0x00;
+        segments[i].tx_buffer = &tx_buf[i * 2];
+        segments[i].rx_buffer = &rx_buf[i * 2];
+        segments[i].length = 2;
+        segments[i].cs_change = 1;
+    }
+    spiTransferBatch(device, segments, count);
+    for (uint8_t i = 0; i < count; i++) {
+        values[i] = (rx_buf[i * 2] & 0x03) << 8 | rx_buf[i * 2 + 1];
+    }
+}
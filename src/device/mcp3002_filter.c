@@ -0,0 +1,259 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "device/mcp3002_filter.h"
+#include "utility/clock.h"
+
+static int32_t const mcp3002_filter_code_max = 1023;
+
+// Keeps the CIC output inside 32 bits once the combs undo the wrapping. The
+// FIR sum is 64 bits, the tap gain only bounds its output at twice the input.
+static int64_t const mcp3002_filter_cic_gain_max = 1 << 17;
+static int32_t const mcp3002_filter_fir_gain_max = 1 << 16;
+
+static uint32_t mcp3002FilterCic(struct mcp3002_cic_t* cic, int32_t* block,
+                                 uint32_t count);
+static uint32_t mcp3002FilterFir(struct mcp3002_fir_t* fir, int32_t* block,
+                                 uint32_t count);
+static uint32_t mcp3002FilterBiquad(struct mcp3002_biquad_t* biquad,
+                                    int32_t* block, uint32_t count);
+
+void mcp3002FilterInitialize(struct mcp3002_filter_t* filter) {
+    memset(filter, 0, sizeof(struct mcp3002_filter_t));
+    filter->ratio = 1;
+}
+
+int8_t mcp3002FilterAddCic(struct mcp3002_filter_t* filter, uint8_t order,
+                           uint16_t ratio) {
+    int64_t gain = 1;
+    if (filter->stage_count == MCP3002_FILTER_STAGE_MAX || order == 0 ||
+        order > MCP3002_FILTER_CIC_ORDER_MAX || ratio == 0) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < order; i++) {
+        gain *= ratio;
+    }
+    if (gain > mcp3002_filter_cic_gain_max) {
+        return -1;
+    }
+    struct mcp3002_filter_stage_t* stage =
+        &filter->stages[filter->stage_count++];
+    memset(stage, 0, sizeof(struct mcp3002_filter_stage_t));
+    stage->type = mcp3002_filter_cic;
+    stage->state.cic.order = order;
+    stage->state.cic.ratio = ratio;
+    stage->state.cic.gain = gain;
+    filter->ratio *= ratio;
+    return 0;
+}
+
+int8_t mcp3002FilterAddFir(struct mcp3002_filter_t* filter,
+                           int16_t const* taps, uint16_t tap_count,
+                           uint16_t ratio) {
+    int32_t gain = 0;
+    if (filter->stage_count == MCP3002_FILTER_STAGE_MAX || tap_count == 0 ||
+        tap_count > MCP3002_FILTER_TAP_MAX || ratio == 0) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < tap_count; i++) {
+        gain += taps[i] < 0 ? -taps[i] : taps[i];
+    }
+    if (gain > mcp3002_filter_fir_gain_max) {
+        return -1;
+    }
+    struct mcp3002_filter_stage_t* stage =
+        &filter->stages[filter->stage_count++];
+    memset(stage, 0, sizeof(struct mcp3002_filter_stage_t));
+    stage->type = mcp3002_filter_fir;
+    stage->state.fir.ratio = ratio;
+    stage->state.fir.tap_count = tap_count;
+    for (uint16_t i = 0; i < tap_count; i++) {
+        stage->state.fir.taps[i] = taps[i];
+    }
+    filter->ratio *= ratio;
+    return 0;
+}
+
+int8_t mcp3002FilterAddBiquad(struct mcp3002_filter_t* filter,
+                              int32_t const* coefficients) {
+    if (filter->stage_count == MCP3002_FILTER_STAGE_MAX) {
+        return -1;
+    }
+    struct mcp3002_filter_stage_t* stage =
+        &filter->stages[filter->stage_count++];
+    memset(stage, 0, sizeof(struct mcp3002_filter_stage_t));
+    stage->type = mcp3002_filter_biquad;
+    stage->state.biquad.b0 = coefficients[0];
+    stage->state.biquad.b1 = coefficients[1];
+    stage->state.biquad.b2 = coefficients[2];
+    stage->state.biquad.a1 = coefficients[3];
+    stage->state.biquad.a2 = coefficients[4];
+    return 0;
+}
+
+void mcp3002FilterReset(struct mcp3002_filter_t* filter) {
+    for (uint8_t i = 0; i < filter->stage_count; i++) {
+        struct mcp3002_filter_stage_t* stage = &filter->stages[i];
+        switch (stage->type) {
+        case mcp3002_filter_cic:
+            stage->state.cic.phase = 0;
+            memset(stage->state.cic.integrator, 0,
+                   sizeof(stage->state.cic.integrator));
+            memset(stage->state.cic.comb, 0, sizeof(stage->state.cic.comb));
+            break;
+        case mcp3002_filter_fir:
+            stage->state.fir.phase = 0;
+            stage->state.fir.index = 0;
+            memset(stage->state.fir.history, 0,
+                   sizeof(stage->state.fir.history));
+            break;
+        case mcp3002_filter_biquad:
+            stage->state.biquad.x1 = 0;
+            stage->state.biquad.x2 = 0;
+            stage->state.biquad.y1 = 0;
+            stage->state.biquad.y2 = 0;
+            break;
+        }
+    }
+    filter->samples_in = 0;
+    filter->samples_out = 0;
+    filter->time = 0;
+}
+
+uint32_t mcp3002FilterProcess(struct mcp3002_filter_t* filter,
+                              uint16_t const* codes, uint32_t count,
+                              uint16_t* output) {
+    uint64_t start = clockGetTime();
+    uint32_t produced = 0;
+    int32_t* block = filter->block;
+    for (uint32_t offset = 0; offset < count;
+         offset += MCP3002_FILTER_BLOCK) {
+        uint32_t length = count - offset < MCP3002_FILTER_BLOCK
+                              ? count - offset
+                              : MCP3002_FILTER_BLOCK;
+        for (uint32_t i = 0; i < length; i++) {
+            block[i] = (int32_t)codes[offset + i] << MCP3002_FILTER_SHIFT;
+        }
+
+        // Every stage works in place, decimation only ever shrinks the block
+        for (uint8_t i = 0; i < filter->stage_count && length != 0; i++) {
+            struct mcp3002_filter_stage_t* stage = &filter->stages[i];
+            switch (stage->type) {
+            case mcp3002_filter_cic:
+                length = mcp3002FilterCic(&stage->state.cic, block, length);
+                break;
+            case mcp3002_filter_fir:
+                length = mcp3002FilterFir(&stage->state.fir, block, length);
+                break;
+            case mcp3002_filter_biquad:
+                length =
+                    mcp3002FilterBiquad(&stage->state.biquad, block, length);
+                break;
+            }
+        }
+        for (uint32_t i = 0; i < length; i++) {
+            int32_t code = (block[i] + (1 << (MCP3002_FILTER_SHIFT - 1))) >>
+                           MCP3002_FILTER_SHIFT;
+            if (code < 0) {
+                code = 0;
+            } else if (code > mcp3002_filter_code_max) {
+                code = mcp3002_filter_code_max;
+            }
+            output[produced + i] = (uint16_t)code;
+        }
+        produced += length;
+    }
+    filter->samples_in += count;
+    filter->samples_out += produced;
+    filter->time += clockGetTime() - start;
+    return produced;
+}
+
+void mcp3002FilterGetStatistics(
+    struct mcp3002_filter_t* filter,
+    struct mcp3002_filter_statistics_t* statistics) {
+    statistics->samples_in = filter->samples_in;
+    statistics->samples_out = filter->samples_out;
+    statistics->ratio = filter->ratio;
+    statistics->ns_per_sample =
+        filter->samples_in ? (double)filter->time / filter->samples_in : 0.0;
+}
+
+static uint32_t mcp3002FilterCic(struct mcp3002_cic_t* cic, int32_t* block,
+                                 uint32_t count) {
+    uint32_t produced = 0;
+    uint8_t order = cic->order;
+    for (uint32_t i = 0; i < count; i++) {
+        // Integrators may wrap, the combs undo it as long as the gain fits
+        uint32_t value = (uint32_t)block[i];
+        for (uint8_t j = 0; j < order; j++) {
+            value += (uint32_t)cic->integrator[j];
+            cic->integrator[j] = (int32_t)value;
+        }
+        if (++cic->phase < cic->ratio) {
+            continue;
+        }
+        cic->phase = 0;
+        for (uint8_t j = 0; j < order; j++) {
+            uint32_t previous = (uint32_t)cic->comb[j];
+            cic->comb[j] = (int32_t)value;
+            value -= previous;
+        }
+        int64_t sum = (int32_t)value;
+        block[produced++] = (int32_t)((sum + cic->gain / 2) / cic->gain);
+    }
+    return produced;
+}
+
+static uint32_t mcp3002FilterFir(struct mcp3002_fir_t* fir, int32_t* block,
+                                 uint32_t count) {
+    uint32_t produced = 0;
+    uint16_t tap_count = fir->tap_count;
+    int32_t const* taps = fir->taps;
+    for (uint32_t i = 0; i < count; i++) {
+        // The delay line is stored twice so the taps always read linearly
+        fir->index = (fir->index == 0 ? tap_count : fir->index) - 1;
+        fir->history[fir->index] = block[i];
+        fir->history[fir->index + tap_count] = block[i];
+        if (++fir->phase < fir->ratio) {
+            continue;
+        }
+        fir->phase = 0;
+        int32_t const* history = &fir->history[fir->index];
+        // A biquad upstream can amplify, so the input is any 32 bit value
+        int64_t sum = 0;
+        for (uint16_t j = 0; j < tap_count; j++) {
+            sum += (int64_t)taps[j] * history[j];
+        }
+        sum += 1 << (MCP3002_FILTER_FIR_SHIFT - 1);
+        block[produced++] = (int32_t)(sum >> MCP3002_FILTER_FIR_SHIFT);
+    }
+    return produced;
+}
+
+static uint32_t mcp3002FilterBiquad(struct mcp3002_biquad_t* biquad,
+                                    int32_t* block, uint32_t count) {
+    int32_t x1 = biquad->x1;
+    int32_t x2 = biquad->x2;
+    int32_t y1 = biquad->y1;
+    int32_t y2 = biquad->y2;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t x = block[i];
+        int64_t sum = (int64_t)biquad->b0 * x + (int64_t)biquad->b1 * x1 +
+                      (int64_t)biquad->b2 * x2 - (int64_t)biquad->a1 * y1 -
+                      (int64_t)biquad->a2 * y2;
+        sum += 1 << (MCP3002_FILTER_BIQUAD_SHIFT - 1);
+        int32_t y = (int32_t)(sum >> MCP3002_FILTER_BIQUAD_SHIFT);
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        block[i] = y;
+    }
+    biquad->x1 = x1;
+    biquad->x2 = x2;
+    biquad->y1 = y1;
+    biquad->y2 = y2;
+    return count;
+}
@@ -0,0 +1,139 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "device/mcp3002.h"
+#include "device/mcp3002_stream.h"
+#include "utility/clock.h"
+
+static uint64_t const mcp3002_stream_spin_time = 200000;
+static uint32_t const mcp3002_stream_rate_max = 1000000000;
+static uint32_t const mcp3002_stream_capacity_max = 1u << 31;
+
+static void* mcp3002StreamRun(void* argument);
+static void mcp3002StreamWait(uint64_t time);
+static void mcp3002StreamPush(struct mcp3002_stream_t* stream,
+                              struct mcp3002_sample_t* sample);
+
+int8_t mcp3002StreamStart(struct mcp3002_stream_t* stream,
+                          struct mcp3002_t* device,
+                          struct mcp3002_stream_settings_t* settings) {
+    uint32_t capacity = 1;
+    if ((settings->channel_mask & mcp3002_channel_mask_all) == 0 ||
+        settings->rate == 0 || settings->rate > mcp3002_stream_rate_max ||
+        settings->capacity > mcp3002_stream_capacity_max) {
+        return -1;
+    }
+    while (capacity < settings->capacity) {
+        capacity <<= 1;
+    }
+    stream->device = device;
+    stream->settings = *settings;
+    stream->buffer = calloc(capacity, sizeof(struct mcp3002_sample_t));
+    if (stream->buffer == NULL) {
+        return -1;
+    }
+    stream->mask = capacity - 1;
+    atomic_init(&stream->head, 0);
+    atomic_init(&stream->tail, 0);
+    atomic_init(&stream->samples, 0);
+    atomic_init(&stream->overruns, 0);
+    atomic_init(&stream->dropped, 0);
+    atomic_init(&stream->running, 1);
+    stream->start_time = clockGetTime();
+    if (pthread_create(&stream->thread, NULL, mcp3002StreamRun, stream) != 0) {
+        free(stream->buffer);
+        stream->buffer = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void mcp3002StreamStop(struct mcp3002_stream_t* stream) {
+    if (stream->buffer == NULL) {
+        return;
+    }
+    atomic_store(&stream->running, 0);
+    pthread_join(stream->thread, NULL);
+    free(stream->buffer);
+    stream->buffer = NULL;
+}
+
+uint32_t mcp3002StreamRead(struct mcp3002_stream_t* stream,
+                           struct mcp3002_sample_t* samples, uint32_t count) {
+    uint64_t tail = atomic_load_explicit(&stream->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&stream->head, memory_order_acquire);
+    if (head - tail < count) {
+        count = (uint32_t)(head - tail);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        samples[i] = stream->buffer[(tail + i) & stream->mask];
+    }
+    atomic_store_explicit(&stream->tail, tail + count, memory_order_release);
+    return count;
+}
+
+void mcp3002StreamGetStatistics(struct mcp3002_stream_t* stream,
+                                struct mcp3002_stream_statistics_t* statistics) {
+    uint64_t elapsed = clockGetTime() - stream->start_time;
+    statistics->samples = atomic_load(&stream->samples);
+    statistics->overruns = atomic_load(&stream->overruns);
+    statistics->dropped = atomic_load(&stream->dropped);
+    statistics->rate =
+        elapsed != 0 ? statistics->samples * 1e9 / (double)elapsed : 0.0;
+}
+
+static void* mcp3002StreamRun(void* argument) {
+    struct mcp3002_stream_t* stream = argument;
+    uint64_t period = 1000000000 / stream->settings.rate;
+    uint64_t next = clockGetTime();
+    uint64_t now;
+    uint16_t values[4];
+    struct mcp3002_sample_t sample;
+    while (atomic_load_explicit(&stream->running, memory_order_relaxed)) {
+        uint8_t index = 0;
+        mcp3002StreamWait(next);
+        mcp3002ReadChannels(stream->device, stream->settings.channel_mask, 1,
+                            values);
+        sample.timestamp = clockGetTime();
+        for (uint8_t i = 0; i < 4; i++) {
+            if (stream->settings.channel_mask & (1 << i)) {
+                sample.channel = (enum mcp3002_channel_t)(i << 4);
+                sample.value = values[index++];
+                mcp3002StreamPush(stream, &sample);
+            }
+        }
+        next += period;
+        now = clockGetTime();
+        if (now >= next + period) {
+            uint64_t missed = (now - next) / period;
+            atomic_fetch_add_explicit(&stream->overruns, missed,
+                                      memory_order_relaxed);
+            next += missed * period;
+        }
+    }
+    return NULL;
+}
+
+static void mcp3002StreamWait(uint64_t time) {
+    uint64_t now = clockGetTime();
+    if (time > now + mcp3002_stream_spin_time) {
+        clockSleepUntil(time - mcp3002_stream_spin_time / 2);
+    }
+    while (clockGetTime() < time) {
+    }
+}
+
+static void mcp3002StreamPush(struct mcp3002_stream_t* stream,
+                              struct mcp3002_sample_t* sample) {
+    uint64_t head = atomic_load_explicit(&stream->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&stream->tail, memory_order_acquire);
+    atomic_fetch_add_explicit(&stream->samples, 1, memory_order_relaxed);
+    if (head - tail > stream->mask) {
+        atomic_fetch_add_explicit(&stream->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    stream->buffer[head & stream->mask] = *sample;
+    atomic_store_explicit(&stream->head, head + 1, memory_order_release);
+}
@@ -5,10 +5,14 @@
 
 #include "device/tsl2561.h"
 #include "interface/i2c.h"
+#include "utility/clock.h"
+#include "utility/instrument.h"
 
 #include <unistd.h>
-void delay(uint16_t ms) {
+static void delay(i2c_device_t device, uint16_t ms) {
+    INSTRUMENT_START(start);
     usleep(ms * 1000);
+    INSTRUMENT_DELAY(instrument_interface_i2c, device, start);
 }
 
 uint8_t const tsl2561_addr_low = 0x29;
@@ -19,13 +23,17 @@ static uint8_t const tsl2561_control_addr = 0x80;
 static uint8_t const tsl2561_timing_addr = 0x81;
 static uint8_t const tsl2561_id_addr = 0x8A;
 static uint8_t const tsl2561_channel0_data_addr = 0x8C;
-static uint8_t const tsl2561_channel1_data_addr = 0x8E;
 
 static uint8_t const tsl2561_control_power_off = 0x00;
 static uint8_t const tsl2561_control_power_on = 0x03;
 
 static uint8_t const tsl2561_device_id = 0x10;
 
+static uint64_t const tsl2561_integration_time[3] = {13700000, 101000000,
+                                                     402000000};
+static uint64_t const tsl2561_integration_margin = 1000000;
+static uint64_t const tsl2561_power_on_time = 50000000;
+
 static void tsl2561SetReg(i2c_device_t i2c_device, uint8_t address,
                           uint8_t data);
 static void tsl2561GetReg(i2c_device_t i2c_device, uint8_t address,
@@ -33,57 +41,124 @@ static void tsl2561GetReg(i2c_device_t i2c_device, uint8_t address,
 
 static void tsl2561PowerOff(i2c_device_t i2c_device);
 static void tsl2561PowerOn(i2c_device_t i2c_device);
+static void tsl2561ApplySettings(struct tsl2561_t* device,
+                                 struct tsl2561_settings_t* settings);
+
+static void tsl2561ReadData(i2c_device_t i2c_device,
+                            struct tsl2561_data_t* data);
 
 void tsl2561Initialize(struct tsl2561_t* device, i2c_device_t i2c_device) {
+    uint64_t ready_time;
+    if (tsl2561StartInitialize(device, i2c_device, &ready_time) != 0) {
+        return;
+    }
+    INSTRUMENT_START(start);
+    clockSleepUntil(ready_time);
+    INSTRUMENT_DELAY(instrument_interface_i2c, device->i2c_device, start);
+    tsl2561FinishInitialize(device);
+}
+
+int8_t tsl2561StartInitialize(struct tsl2561_t* device,
+                              i2c_device_t i2c_device, uint64_t* ready_time) {
     device->i2c_device = i2c_device;
+    uint8_t reg_data[1];
+    device->integration_start = 0;
+    device->integration_count = 0;
+    tsl2561GetReg(device->i2c_device, tsl2561_id_addr, reg_data, 1);
+    if (!(reg_data[0] & tsl2561_device_id)) {
+        return -1;
+    }
+    tsl2561SetReg(device->i2c_device, tsl2561_control_addr,
+                  tsl2561_control_power_on);
+    *ready_time = clockGetTime() + tsl2561_power_on_time;
+    return 0;
+}
+
+int8_t tsl2561FinishInitialize(struct tsl2561_t* device) {
     struct tsl2561_settings_t settings = {
         .gain = tsl2561_gain_16x,
         .integral = tsl2561_integral_402ms,
+        .mode = tsl2561_mode_oneshot,
     };
-    uint8_t reg_data[1];
-    tsl2561GetReg(device->i2c_device, tsl2561_id_addr, reg_data, 1);
-    if (reg_data[0] & tsl2561_device_id) {
-        tsl2561SetDeviceSettings(device, &settings);
-    }
+    tsl2561ApplySettings(device, &settings);
+    return 0;
 }
 
 void tsl2561SetDeviceSettings(struct tsl2561_t* device,
                               struct tsl2561_settings_t* settings) {
-    tsl2561PowerOn(device->i2c_device);
-    device->settings.gain = settings->gain;
-    device->settings.integral = settings->integral;
-    tsl2561SetReg(device->i2c_device, tsl2561_timing_addr,
-                  device->settings.gain | device->settings.integral);
-    tsl2561PowerOff(device->i2c_device);
+    // A continuous device is already powered, only one-shot needs waking
+    if (device->settings.mode != tsl2561_mode_continuous) {
+        tsl2561PowerOn(device->i2c_device);
+    }
+    tsl2561ApplySettings(device, settings);
 }
 
 void tsl2561ReadDeviceData(struct tsl2561_t* device,
                            struct tsl2561_data_t* data) {
+    if (device->settings.mode == tsl2561_mode_continuous) {
+        INSTRUMENT_START(start);
+        clockSleepUntil(tsl2561GetReadyTime(device));
+        INSTRUMENT_DELAY(instrument_interface_i2c, device->i2c_device, start);
+        tsl2561FetchDeviceData(device, data);
+        return;
+    }
     tsl2561PowerOn(device->i2c_device);
     switch (device->settings.integral) {
     case tsl2561_integral_13ms:
-        delay(14);
+        delay(device->i2c_device, 14);
         break;
     case tsl2561_integral_101ms:
-        delay(102);
+        delay(device->i2c_device, 102);
         break;
     case tsl2561_integral_402ms:
-        delay(403);
+        delay(device->i2c_device, 403);
         break;
     }
-    uint8_t ch0_buf[2];
-    uint8_t ch1_buf[2];
-    tsl2561GetReg(device->i2c_device, tsl2561_channel0_data_addr, ch0_buf, 2);
-    tsl2561GetReg(device->i2c_device, tsl2561_channel1_data_addr, ch1_buf, 2);
-    data->channel_0 = ch0_buf[1] << 8 | ch0_buf[0];
-    data->channel_1 = ch1_buf[1] << 8 | ch1_buf[0];
+    tsl2561ReadData(device->i2c_device, data);
     tsl2561PowerOff(device->i2c_device);
 }
 
+uint64_t tsl2561StartConversion(struct tsl2561_t* device) {
+    if (device->settings.mode != tsl2561_mode_continuous) {
+        tsl2561SetReg(device->i2c_device, tsl2561_control_addr,
+                      tsl2561_control_power_on);
+        device->integration_start = clockGetTime();
+        device->integration_count = 0;
+    }
+    return tsl2561GetReadyTime(device);
+}
+
+uint64_t tsl2561GetReadyTime(struct tsl2561_t* device) {
+    return device->integration_start +
+           (device->integration_count + 1) *
+               tsl2561_integration_time[device->settings.integral] +
+           tsl2561_integration_margin;
+}
+
+int8_t tsl2561FetchDeviceData(struct tsl2561_t* device,
+                              struct tsl2561_data_t* data) {
+    uint64_t now = clockGetTime();
+    if (now < tsl2561GetReadyTime(device)) {
+        return -1;
+    }
+    tsl2561ReadData(device->i2c_device, data);
+    if (device->settings.mode == tsl2561_mode_continuous) {
+        device->integration_count =
+            (now - device->integration_start - tsl2561_integration_margin) /
+            tsl2561_integration_time[device->settings.integral];
+    } else {
+        tsl2561PowerOff(device->i2c_device);
+    }
+    return 0;
+}
+
 #ifdef TSL2561_FLOAT_ENABLE
 
-double tsl2561CalculateIlluminance(struct tsl2561_t* device,
-                                   struct tsl2561_data_t* data) {
+static double const tsl2561_integral_scale[3] = {402.0 / 13.7, 402.0 / 101.0,
+                                                 1.0};
+
+static double tsl2561CalculateRawIlluminance(
+    struct tsl2561_data_t const* data) {
     double illuminance;
     if (data->channel_0 != 0) {
         double result = (double)data->channel_1 / (double)data->channel_0;
@@ -117,110 +192,120 @@ double tsl2561CalculateIlluminance(struct tsl2561_t* device,
     } else {
         illuminance = 0.0;
     }
+    return illuminance;
+}
+
+double tsl2561CalculateIlluminance(struct tsl2561_t* device,
+                                   struct tsl2561_data_t* data) {
+    double illuminance = tsl2561CalculateRawIlluminance(data);
     if (device->settings.gain == tsl2561_gain_1x) {
         illuminance *= 16;
     }
-    switch (device->settings.integral) {
-    case tsl2561_integral_13ms:
-        illuminance *= 402.0 / 13.7;
-        break;
-    case tsl2561_integral_101ms:
-        illuminance *= 402.0 / 101.0;
-        break;
-    default:
-        break;
-    }
+    illuminance *= tsl2561_integral_scale[device->settings.integral];
     return illuminance;
 }
 
+void tsl2561CalculateIlluminanceBatch(struct tsl2561_t* device,
+                                      struct tsl2561_data_t const* data,
+                                      double* illuminance, uint32_t count) {
+    double gain_scale = device->settings.gain == tsl2561_gain_1x ? 16 : 1;
+    double integral_scale = tsl2561_integral_scale[device->settings.integral];
+    for (uint32_t i = 0; i < count; i++) {
+        illuminance[i] = tsl2561CalculateRawIlluminance(&data[i]) *
+                         gain_scale * integral_scale;
+    }
+}
+
 #else
 
-uint32_t tsl2561CalculateIlluminance(struct tsl2561_t* device,
-                                     struct tsl2561_data_t* data) {
-    uint32_t chScale;
-    uint32_t channel0;
-    uint32_t channel1;
-    uint32_t ratio = 0;
-    uint16_t b, m;
-    uint32_t temp;
-    uint32_t illuminance;
-    switch (device->settings.integral) {
-    case tsl2561_integral_13ms:
-        chScale = 0x7517;
-        break;
-    case tsl2561_integral_101ms:
-        chScale = 0x0FE7;
-        break;
-    case tsl2561_integral_402ms:
-        chScale = 0x0400;
-        break;
-    }
-    if (device->settings.gain == tsl2561_gain_1x) {
+static uint16_t const tsl2561_channel_scale[3] = {0x7517, 0x0FE7, 0x0400};
+
+#ifdef TSL2561_PACKAGE_CS
+static uint32_t const tsl2561_ratio_limit[7] = {0x0043, 0x0085, 0x00c8, 0x010a,
+                                                0x014d, 0x019a, 0x029a};
+static uint16_t const tsl2561_coefficient_b[8] = {
+    0x0204, 0x0228, 0x0253, 0x0282, 0x0177, 0x0101, 0x0037, 0x0000};
+static uint16_t const tsl2561_coefficient_m[8] = {
+    0x01ad, 0x02c1, 0x0363, 0x03df, 0x01dd, 0x0127, 0x002b, 0x0000};
+#else
+static uint32_t const tsl2561_ratio_limit[7] = {0x0040, 0x0080, 0x00c0, 0x0100,
+                                                0x0138, 0x019a, 0x029a};
+static uint16_t const tsl2561_coefficient_b[8] = {
+    0x01f2, 0x0214, 0x023f, 0x0270, 0x016f, 0x00d2, 0x0018, 0x0000};
+static uint16_t const tsl2561_coefficient_m[8] = {
+    0x01be, 0x02d1, 0x037b, 0x03fe, 0x01fc, 0x00fb, 0x0012, 0x0000};
+#endif
+
+static uint32_t tsl2561GetChannelScale(struct tsl2561_settings_t* settings) {
+    uint32_t chScale = tsl2561_channel_scale[settings->integral];
+    if (settings->gain == tsl2561_gain_1x) {
         chScale = chScale << 4;
     }
-    channel0 = (data->channel_0 * chScale) >> 10;
-    channel1 = (data->channel_1 * chScale) >> 10;
-    if (channel0 != 0) {
-        ratio = (channel1 << 10) / channel0;
-    }
-    ratio = (ratio + 1) >> 1;
-#ifdef TSL2561_PACKAGE_CS
-    if (ratio <= 0x0043) {
-        b = 0x0204;
-        m = 0x01ad;
-    } else if (ratio <= 0x0085) {
-        b = 0x0228;
-        m = 0x02c1;
-    } else if (ratio <= 0x00c8) {
-        b = 0x0253;
-        m = 0x0363;
-    } else if (ratio <= 0x010a) {
-        b = 0x0282;
-        m = 0x03df;
-    } else if (ratio <= 0x014d) {
-        b = 0x0177;
-        m = 0x01dd;
-    } else if (ratio <= 0x019a) {
-        b = 0x0101;
-        m = 0x0127;
-    } else if (ratio <= 0x029a) {
-        b = 0x0037;
-        m = 0x002b;
-    } else if (ratio > 0x029a) {
-        b = 0x0000;
-        m = 0x0000;
+    return chScale;
+}
+
+static inline uint32_t tsl2561ScaleIlluminance(uint32_t chScale,
+                                               uint32_t channel_0,
+                                               uint32_t channel_1) {
+    uint32_t channel0 = (channel_0 * chScale) >> 10;
+    uint32_t channel1 = (channel_1 * chScale) >> 10;
+    uint32_t numerator = channel1 << 10;
+    uint32_t b = tsl2561_coefficient_b[0];
+    uint32_t m = tsl2561_coefficient_m[0];
+    uint32_t temp;
+    for (uint32_t i = 0; i < 7; i++) {
+        // ratio > limit, rewritten so that only constants are divisors
+        uint32_t limit = 2 * tsl2561_ratio_limit[i] + 1;
+        uint32_t above = channel0 != 0 && numerator / limit >= channel0;
+        b = above ? tsl2561_coefficient_b[i + 1] : b;
+        m = above ? tsl2561_coefficient_m[i + 1] : m;
     }
-#else
-    if (ratio <= 0x0040) {
-        b = 0x01f2;
-        m = 0x01be;
-    } else if (ratio <= 0x0080) {
-        b = 0x0214;
-        m = 0x02d1;
-    } else if (ratio <= 0x00c0) {
-        b = 0x023f;
-        m = 0x037b;
-    } else if (ratio <= 0x0100) {
-        b = 0x0270;
-        m = 0x03fe;
-    } else if (ratio <= 0x0138) {
-        b = 0x016f;
-        m = 0x01fc;
-    } else if (ratio <= 0x019a) {
-        b = 0x00d2;
-        m = 0x00fb;
-    } else if (ratio <= 0x029a) {
-        b = 0x0018;
-        m = 0x0012;
-    } else if (ratio > 0x029a) {
-        b = 0x0000;
-        m = 0x0000;
+    temp = ((channel0 * b) - (channel1 * m));
+    temp += (1 << 13);
+    return temp >> 14;
+}
+
+static inline uint32_t tsl2561ScaleIlluminanceVector(uint32_t chScale,
+                                                     uint32_t channel_0,
+                                                     uint32_t channel_1) {
+    uint32_t channel0 = (channel_0 * chScale) >> 10;
+    uint32_t channel1 = (channel_1 * chScale) >> 10;
+    uint32_t numerator = channel1 << 10;
+    uint32_t valid = channel0 != 0;
+    uint32_t b = tsl2561_coefficient_b[0];
+    uint32_t m = tsl2561_coefficient_m[0];
+    uint32_t temp;
+
+    // Step through the segments by adding the coefficient deltas of every
+    // limit the ratio is above, no branches or table lookups so the batch
+    // loop vectorizes. ratio > limit is rewritten so only constants divide.
+    for (uint32_t i = 0; i < 7; i++) {
+        uint32_t limit = 2 * tsl2561_ratio_limit[i] + 1;
+        uint32_t above = valid & (numerator / limit >= channel0);
+        b += above * (uint32_t)(tsl2561_coefficient_b[i + 1] -
+                                tsl2561_coefficient_b[i]);
+        m += above * (uint32_t)(tsl2561_coefficient_m[i + 1] -
+                                tsl2561_coefficient_m[i]);
     }
-#endif
     temp = ((channel0 * b) - (channel1 * m));
     temp += (1 << 13);
-    illuminance = temp >> 14;
-    return illuminance;
+    return temp >> 14;
+}
+
+uint32_t tsl2561CalculateIlluminance(struct tsl2561_t* device,
+                                     struct tsl2561_data_t* data) {
+    return tsl2561ScaleIlluminance(tsl2561GetChannelScale(&device->settings),
+                                   data->channel_0, data->channel_1);
+}
+
+void tsl2561CalculateIlluminanceBatch(struct tsl2561_t* device,
+                                      struct tsl2561_data_t const* data,
+                                      uint32_t* illuminance, uint32_t count) {
+    uint32_t chScale = tsl2561GetChannelScale(&device->settings);
+    for (uint32_t i = 0; i < count; i++) {
+        illuminance[i] = tsl2561ScaleIlluminanceVector(
+            chScale, data[i].channel_0, data[i].channel_1);
+    }
 }
 
 #endif
@@ -235,10 +320,7 @@ static void tsl2561SetReg(i2c_device_t i2c_device, uint8_t address,
 
 static void tsl2561GetReg(i2c_device_t i2c_device, uint8_t address,
                           uint8_t* data, uint8_t length) {
-    uint8_t tx_buf[1];
-    tx_buf[0] = address;
-    i2cWrite(i2c_device, tx_buf, 1);
-    i2cRead(i2c_device, data, length);
+    i2cReadBlock(i2c_device, address, data, length);
 }
 
 static void tsl2561PowerOff(i2c_device_t i2c_device) {
@@ -246,5 +328,28 @@ static void tsl2561PowerOff(i2c_device_t i2c_device) {
 }
 static void tsl2561PowerOn(i2c_device_t i2c_device) {
     tsl2561SetReg(i2c_device, tsl2561_control_addr, tsl2561_control_power_on);
-    delay(50);
+    delay(i2c_device, 50);
+}
+
+static void tsl2561ApplySettings(struct tsl2561_t* device,
+                                 struct tsl2561_settings_t* settings) {
+    device->settings.gain = settings->gain;
+    device->settings.integral = settings->integral;
+    device->settings.mode = settings->mode;
+    tsl2561SetReg(device->i2c_device, tsl2561_timing_addr,
+                  device->settings.gain | device->settings.integral);
+    if (device->settings.mode == tsl2561_mode_continuous) {
+        device->integration_start = clockGetTime();
+        device->integration_count = 0;
+    } else {
+        tsl2561PowerOff(device->i2c_device);
+    }
+}
+
+static void tsl2561ReadData(i2c_device_t i2c_device,
+                            struct tsl2561_data_t* data) {
+    uint8_t data_buf[4];
+    tsl2561GetReg(i2c_device, tsl2561_channel0_data_addr, data_buf, 4);
+    data->channel_0 = data_buf[1] << 8 | data_buf[0];
+    data->channel_1 = data_buf[3] << 8 | data_buf[2];
 }
@@ -0,0 +1,380 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "interface/bus.h"
+#include "interface/i2c.h"
+#include "interface/spi.h"
+
+static uint8_t const bus_merge_max = 255;
+
+static void* busRun(void* argument);
+static struct bus_transaction_t* busExecuteSpi(
+    struct bus_transaction_t* transaction);
+static struct bus_transaction_t* busExecuteI2c(
+    struct bus_transaction_t* transaction);
+static void busComplete(struct bus_transaction_t* transaction,
+                        int32_t result);
+
+int8_t busInitialize(struct bus_executor_t* executor) {
+    executor->head = NULL;
+    executor->tail = NULL;
+    executor->running = 1;
+    pthread_mutex_init(&executor->mutex, NULL);
+    pthread_cond_init(&executor->submitted, NULL);
+    pthread_cond_init(&executor->completed, NULL);
+    if (pthread_create(&executor->thread, NULL, busRun, executor) != 0) {
+        pthread_mutex_destroy(&executor->mutex);
+        pthread_cond_destroy(&executor->submitted);
+        pthread_cond_destroy(&executor->completed);
+        return -1;
+    }
+    return 0;
+}
+
+void busFinalize(struct bus_executor_t* executor) {
+    pthread_mutex_lock(&executor->mutex);
+    executor->running = 0;
+    pthread_cond_signal(&executor->submitted);
+    pthread_mutex_unlock(&executor->mutex);
+    pthread_join(executor->thread, NULL);
+    pthread_mutex_destroy(&executor->mutex);
+    pthread_cond_destroy(&executor->submitted);
+    pthread_cond_destroy(&executor->completed);
+}
+
+void busSubmit(struct bus_transaction_t* transaction) {
+    struct bus_executor_t* executor = transaction->device->executor;
+    atomic_init(&transaction->done, 0);
+    transaction->next = NULL;
+    pthread_mutex_lock(&executor->mutex);
+    if (executor->tail == NULL) {
+        executor->head = transaction;
+    } else {
+        executor->tail->next = transaction;
+    }
+    executor->tail = transaction;
+    pthread_cond_signal(&executor->submitted);
+    pthread_mutex_unlock(&executor->mutex);
+}
+
+int32_t busWait(struct bus_transaction_t* transaction) {
+    struct bus_executor_t* executor = transaction->device->executor;
+    if (!atomic_load_explicit(&transaction->done, memory_order_acquire)) {
+        pthread_mutex_lock(&executor->mutex);
+        while (!atomic_load_explicit(&transaction->done,
+                                     memory_order_acquire)) {
+            pthread_cond_wait(&executor->completed, &executor->mutex);
+        }
+        pthread_mutex_unlock(&executor->mutex);
+    }
+    return transaction->result;
+}
+
+int8_t busSpiTransfer(struct bus_transaction_t* transaction,
+                      spi_device_t device, uint8_t* tx_buffer,
+                      uint8_t* rx_buffer, uint16_t length,
+                      bus_callback_t callback, void* context) {
+    // Only devices opened through the bus backend carry a bus_device_t
+    if (spiGetBackend(device) != &bus_spi_backend) {
+        return -1;
+    }
+    transaction->operation = bus_operation_spi_transfer;
+    transaction->device = spiGetContext(device);
+    transaction->tx_buffer = tx_buffer;
+    transaction->tx_length = length;
+    transaction->rx_buffer = rx_buffer;
+    transaction->rx_length = length;
+    transaction->callback = callback;
+    transaction->context = context;
+    busSubmit(transaction);
+    return 0;
+}
+
+int8_t busI2cWriteRead(struct bus_transaction_t* transaction,
+                       i2c_device_t device, uint8_t* tx_buffer,
+                       uint16_t tx_length, uint8_t* rx_buffer,
+                       uint16_t rx_length, bus_callback_t callback,
+                       void* context) {
+    if (i2cGetBackend(device) != &bus_i2c_backend) {
+        return -1;
+    }
+    transaction->operation = bus_operation_i2c_write_read;
+    transaction->device = i2cGetContext(device);
+    transaction->tx_buffer = tx_buffer;
+    transaction->tx_length = tx_length;
+    transaction->rx_buffer = rx_buffer;
+    transaction->rx_length = rx_length;
+    transaction->callback = callback;
+    transaction->context = context;
+    busSubmit(transaction);
+    return 0;
+}
+
+static int32_t busSpiOpen(struct spi_settings_t* settings, void** context) {
+    struct bus_settings_t* bus_settings = settings->backend_data;
+    struct spi_settings_t inner_settings = *settings;
+    struct bus_device_t* device;
+    if (bus_settings == NULL || bus_settings->spi_backend == NULL) {
+        return -1;
+    }
+    device = malloc(sizeof(struct bus_device_t));
+    if (device == NULL) {
+        return -1;
+    }
+    device->executor = bus_settings->executor;
+    device->spi_backend = bus_settings->spi_backend;
+    device->i2c_backend = NULL;
+    inner_settings.backend = bus_settings->spi_backend;
+    inner_settings.backend_data = bus_settings->backend_data;
+    if (device->spi_backend->open(&inner_settings, &device->context) < 0) {
+        free(device);
+        return -1;
+    }
+    *context = device;
+    return 0;
+}
+
+static int32_t busI2cOpen(struct i2c_settings_t* settings, void** context) {
+    struct bus_settings_t* bus_settings = settings->backend_data;
+    struct i2c_settings_t inner_settings = *settings;
+    struct bus_device_t* device;
+    if (bus_settings == NULL || bus_settings->i2c_backend == NULL) {
+        return -1;
+    }
+    device = malloc(sizeof(struct bus_device_t));
+    if (device == NULL) {
+        return -1;
+    }
+    device->executor = bus_settings->executor;
+    device->spi_backend = NULL;
+    device->i2c_backend = bus_settings->i2c_backend;
+    inner_settings.backend = bus_settings->i2c_backend;
+    inner_settings.backend_data = bus_settings->backend_data;
+    if (device->i2c_backend->open(&inner_settings, &device->context) < 0) {
+        free(device);
+        return -1;
+    }
+    *context = device;
+    return 0;
+}
+
+static void busClose(void* context) {
+    struct bus_device_t* device = context;
+    if (device->spi_backend != NULL) {
+        device->spi_backend->close(device->context);
+    } else {
+        device->i2c_backend->close(device->context);
+    }
+    free(device);
+}
+
+static int32_t busExecute(struct bus_device_t* device,
+                          enum bus_operation_t operation, uint8_t* tx_buffer,
+                          uint16_t tx_length, uint8_t* rx_buffer,
+                          uint16_t rx_length) {
+    struct bus_transaction_t transaction = {
+        .operation = operation,
+        .device = device,
+        .tx_buffer = tx_buffer,
+        .tx_length = tx_length,
+        .rx_buffer = rx_buffer,
+        .rx_length = rx_length,
+    };
+    busSubmit(&transaction);
+    return busWait(&transaction);
+}
+
+static int32_t busSpiTransferSync(void* context, uint8_t* tx_buffer,
+                                  uint8_t* rx_buffer, uint16_t length) {
+    return busExecute(context, bus_operation_spi_transfer, tx_buffer, length,
+                      rx_buffer, length);
+}
+
+static int32_t busSpiTransferBatchSync(void* context,
+                                       struct spi_segment_t* segments,
+                                       uint8_t count) {
+    struct bus_transaction_t transaction = {
+        .operation = bus_operation_spi_transfer_batch,
+        .device = context,
+        .segments = segments,
+        .count = count,
+    };
+    busSubmit(&transaction);
+    return busWait(&transaction);
+}
+
+static int32_t busI2cWriteSync(void* context, uint8_t* tx_buffer,
+                               uint16_t length) {
+    return busExecute(context, bus_operation_i2c_write, tx_buffer, length,
+                      NULL, 0);
+}
+
+static int32_t busI2cReadSync(void* context, uint8_t* rx_buffer,
+                              uint16_t length) {
+    return busExecute(context, bus_operation_i2c_read, NULL, 0, rx_buffer,
+                      length);
+}
+
+static int32_t busI2cWriteReadSync(void* context, uint8_t* tx_buffer,
+                                   uint16_t tx_length, uint8_t* rx_buffer,
+                                   uint16_t rx_length) {
+    return busExecute(context, bus_operation_i2c_write_read, tx_buffer,
+                      tx_length, rx_buffer, rx_length);
+}
+
+struct spi_backend_t const bus_spi_backend = {
+    .open = busSpiOpen,
+    .close = busClose,
+    .transfer = busSpiTransferSync,
+    .transfer_batch = busSpiTransferBatchSync,
+};
+
+struct i2c_backend_t const bus_i2c_backend = {
+    .open = busI2cOpen,
+    .close = busClose,
+    .write = busI2cWriteSync,
+    .read = busI2cReadSync,
+    .write_read = busI2cWriteReadSync,
+};
+
+static void* busRun(void* argument) {
+    struct bus_executor_t* executor = argument;
+    struct bus_transaction_t* transaction;
+    pthread_mutex_lock(&executor->mutex);
+    while (executor->running || executor->head != NULL) {
+        if (executor->head == NULL) {
+            pthread_cond_wait(&executor->submitted, &executor->mutex);
+            continue;
+        }
+        transaction = executor->head;
+        executor->head = NULL;
+        executor->tail = NULL;
+        pthread_mutex_unlock(&executor->mutex);
+        while (transaction != NULL) {
+            if (transaction->device->spi_backend != NULL) {
+                transaction = busExecuteSpi(transaction);
+            } else {
+                transaction = busExecuteI2c(transaction);
+            }
+        }
+        pthread_mutex_lock(&executor->mutex);
+        pthread_cond_broadcast(&executor->completed);
+    }
+    pthread_mutex_unlock(&executor->mutex);
+    return NULL;
+}
+
+static struct bus_transaction_t* busExecuteSpi(
+    struct bus_transaction_t* transaction) {
+    struct bus_device_t* device = transaction->device;
+    struct bus_transaction_t* next = transaction->next;
+    int32_t result;
+    if (transaction->operation == bus_operation_spi_transfer_batch) {
+        result = spiBackendTransferBatch(device->spi_backend, device->context,
+                                         transaction->segments,
+                                         transaction->count);
+        busComplete(transaction, result);
+        return next;
+    }
+    uint8_t count = 1;
+    while (next != NULL && next->device == device &&
+           next->operation == bus_operation_spi_transfer &&
+           count < bus_merge_max) {
+        next = next->next;
+        count++;
+    }
+    if (count > 1 && device->spi_backend->transfer_batch != NULL) {
+        struct spi_segment_t segments[count];
+        struct bus_transaction_t* current = transaction;
+        for (uint8_t i = 0; i < count; i++) {
+            segments[i].tx_buffer = current->tx_buffer;
+            segments[i].rx_buffer = current->rx_buffer;
+            segments[i].length = current->tx_length;
+            segments[i].cs_change = 1;
+            current = current->next;
+        }
+        result = device->spi_backend->transfer_batch(device->context, segments,
+                                                     count);
+        // Each merged transfer reports its own length, or the batch error
+        for (uint8_t i = 0; i < count; i++) {
+            current = transaction->next;
+            busComplete(transaction,
+                        result < 0 ? result : transaction->tx_length);
+            transaction = current;
+        }
+        return next;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        struct bus_transaction_t* current = transaction->next;
+        result = device->spi_backend->transfer(
+            device->context, transaction->tx_buffer, transaction->rx_buffer,
+            transaction->tx_length);
+        busComplete(transaction, result);
+        transaction = current;
+    }
+    return next;
+}
+
+static struct bus_transaction_t* busExecuteI2c(
+    struct bus_transaction_t* transaction) {
+    struct bus_device_t* device = transaction->device;
+    struct i2c_backend_t const* backend = device->i2c_backend;
+    struct bus_transaction_t* next = transaction->next;
+    int32_t result;
+    switch (transaction->operation) {
+    case bus_operation_i2c_write:
+        if (next != NULL && next->device == device &&
+            next->operation == bus_operation_i2c_read &&
+            backend->write_read != NULL) {
+            result = backend->write_read(
+                device->context, transaction->tx_buffer,
+                transaction->tx_length, next->rx_buffer, next->rx_length);
+            // Split the merged result back into the write and the read
+            busComplete(transaction,
+                        result < 0 ? result : transaction->tx_length);
+            result = result < 0 ? result : next->rx_length;
+            transaction = next;
+            next = next->next;
+        } else {
+            result = backend->write(device->context, transaction->tx_buffer,
+                                    transaction->tx_length);
+        }
+        break;
+    case bus_operation_i2c_read:
+        result = backend->read(device->context, transaction->rx_buffer,
+                               transaction->rx_length);
+        break;
+    case bus_operation_i2c_write_read:
+        if (backend->write_read != NULL) {
+            result = backend->write_read(
+                device->context, transaction->tx_buffer,
+                transaction->tx_length, transaction->rx_buffer,
+                transaction->rx_length);
+        } else {
+            result = backend->write(device->context, transaction->tx_buffer,
+                                    transaction->tx_length);
+            if (result >= 0) {
+                result = backend->read(device->context, transaction->rx_buffer,
+                                       transaction->rx_length);
+            }
+        }
+        break;
+    default:
+        result = -1;
+        break;
+    }
+    busComplete(transaction, result);
+    return next;
+}
+
+static void busComplete(struct bus_transaction_t* transaction,
+                        int32_t result) {
+    transaction->result = result;
+    if (transaction->callback != NULL) {
+        transaction->callback(transaction);
+    }
+    atomic_store_explicit(&transaction->done, 1, memory_order_release);
+}
@@ -1,25 +1,111 @@
 #include "interface/i2c.h"
+#include <stddef.h>
 #include <stdint.h>
-#include "pigpio.h"
+
+#include "utility/instrument.h"
+
+#define I2C_DEVICE_MAX 32
+
+struct i2c_slot_t {
+    struct i2c_backend_t const* backend;
+    void* context;
+    uint8_t bus_number;
+};
+
+static struct i2c_slot_t i2c_slots[I2C_DEVICE_MAX];
 
 i2c_device_t i2cInitialize(struct i2c_settings_t* settings) {
-    int8_t device;
-    device = i2cOpen(settings->bus_number, settings->address, 0x00);
-    if (device >= 0) {
-        return (i2c_device_t)device;
-    } else {
-        return 0;
+    struct i2c_backend_t const* backend = settings->backend;
+    if (backend == NULL) {
+#ifdef PIGPIO_ENABLE
+        backend = &i2c_backend_pigpio;
+#else
+        backend = &i2c_backend_i2cdev;
+#endif
+    }
+    for (i2c_device_t device = 1; device < I2C_DEVICE_MAX; device++) {
+        if (i2c_slots[device].backend == NULL) {
+            if (backend->open(settings, &i2c_slots[device].context) < 0) {
+                return 0;
+            }
+            i2c_slots[device].backend = backend;
+            i2c_slots[device].bus_number = settings->bus_number;
+            INSTRUMENT_ATTACH(instrument_interface_i2c, device,
+                              settings->bus_number);
+            return device;
+        }
     }
+    return 0;
 }
 
 void i2cFinalize(i2c_device_t device) {
-    i2cClose(device);
+    if (device == 0 || device >= I2C_DEVICE_MAX ||
+        i2c_slots[device].backend == NULL) {
+        return;
+    }
+    i2c_slots[device].backend->close(i2c_slots[device].context);
+    i2c_slots[device].backend = NULL;
+    i2c_slots[device].context = NULL;
+}
+
+void* i2cGetContext(i2c_device_t device) {
+    return i2c_slots[device % I2C_DEVICE_MAX].context;
+}
+
+struct i2c_backend_t const* i2cGetBackend(i2c_device_t device) {
+    return i2c_slots[device % I2C_DEVICE_MAX].backend;
+}
+
+uint8_t i2cGetBusNumber(i2c_device_t device) {
+    return i2c_slots[device % I2C_DEVICE_MAX].bus_number;
 }
 
 void i2cWrite(i2c_device_t device, uint8_t* tx_buffer, uint16_t length) {
-    i2cWriteDevice(device, (char*)tx_buffer, length);
+    struct i2c_slot_t* slot = &i2c_slots[device % I2C_DEVICE_MAX];
+    if (slot->backend == NULL) {
+        return;
+    }
+    INSTRUMENT_START(start);
+    int32_t result = slot->backend->write(slot->context, tx_buffer, length);
+    INSTRUMENT_TRANSACTION(instrument_interface_i2c, device, length, result,
+                           start);
 }
 
 void i2cRead(i2c_device_t device, uint8_t* rx_buffer, uint16_t length) {
-    i2cReadDevice(device, (char*)rx_buffer, length);
+    struct i2c_slot_t* slot = &i2c_slots[device % I2C_DEVICE_MAX];
+    if (slot->backend == NULL) {
+        return;
+    }
+    INSTRUMENT_START(start);
+    int32_t result = slot->backend->read(slot->context, rx_buffer, length);
+    INSTRUMENT_TRANSACTION(instrument_interface_i2c, device, length, result,
+                           start);
+}
+
+void i2cWriteRead(i2c_device_t device, uint8_t* tx_buffer, uint16_t tx_length,
+                  uint8_t* rx_buffer, uint16_t rx_length) {
+    struct i2c_slot_t* slot = &i2c_slots[device % I2C_DEVICE_MAX];
+    if (slot->backend == NULL) {
+        return;
+    }
+    INSTRUMENT_START(start);
+    int32_t result;
+    if (slot->backend->write_read != NULL) {
+        result = slot->backend->write_read(slot->context, tx_buffer, tx_length,
+                                           rx_buffer, rx_length);
+    } else {
+        result = slot->backend->write(slot->context, tx_buffer, tx_length);
+        int32_t read_result =
+            slot->backend->read(slot->context, rx_buffer, rx_length);
+        if (result >= 0) {
+            result = read_result;
+        }
+    }
+    INSTRUMENT_TRANSACTION(instrument_interface_i2c, device,
+                           tx_length + rx_length, result, start);
+}
+
+void i2cReadBlock(i2c_device_t device, uint8_t address, uint8_t* rx_buffer,
+                  uint16_t length) {
+    i2cWriteRead(device, &address, 1, rx_buffer, length);
 }
@@ -0,0 +1,97 @@
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "interface/i2c.h"
+
+struct i2c_i2cdev_t {
+    int fd;
+    uint16_t address;
+};
+
+static int32_t i2cI2cdevOpen(struct i2c_settings_t* settings, void** context) {
+    char path[32];
+    struct i2c_i2cdev_t* i2cdev;
+    snprintf(path, sizeof(path), "/dev/i2c-%u", settings->bus_number);
+    i2cdev = malloc(sizeof(struct i2c_i2cdev_t));
+    if (i2cdev == NULL) {
+        return -1;
+    }
+    i2cdev->fd = open(path, O_RDWR);
+    i2cdev->address = settings->address;
+    if (i2cdev->fd < 0) {
+        free(i2cdev);
+        return -1;
+    }
+    *context = i2cdev;
+    return 0;
+}
+
+static void i2cI2cdevClose(void* context) {
+    struct i2c_i2cdev_t* i2cdev = context;
+    close(i2cdev->fd);
+    free(i2cdev);
+}
+
+static int32_t i2cI2cdevTransfer(struct i2c_i2cdev_t* i2cdev, uint16_t flags,
+                                 uint8_t* buffer, uint16_t length) {
+    struct i2c_msg message = {
+        .addr = i2cdev->address,
+        .flags = flags,
+        .len = length,
+        .buf = buffer,
+    };
+    struct i2c_rdwr_ioctl_data rdwr = {
+        .msgs = &message,
+        .nmsgs = 1,
+    };
+    return ioctl(i2cdev->fd, I2C_RDWR, &rdwr);
+}
+
+static int32_t i2cI2cdevWrite(void* context, uint8_t* tx_buffer,
+                              uint16_t length) {
+    return i2cI2cdevTransfer(context, 0, tx_buffer, length);
+}
+
+static int32_t i2cI2cdevRead(void* context, uint8_t* rx_buffer,
+                             uint16_t length) {
+    return i2cI2cdevTransfer(context, I2C_M_RD, rx_buffer, length);
+}
+
+static int32_t i2cI2cdevWriteRead(void* context, uint8_t* tx_buffer,
+                                  uint16_t tx_length, uint8_t* rx_buffer,
+                                  uint16_t rx_length) {
+    struct i2c_i2cdev_t* i2cdev = context;
+    struct i2c_msg messages[2] = {
+        {
+            .addr = i2cdev->address,
+            .flags = 0,
+            .len = tx_length,
+            .buf = tx_buffer,
+        },
+        {
+            .addr = i2cdev->address,
+            .flags = I2C_M_RD,
+            .len = rx_length,
+            .buf = rx_buffer,
+        },
+    };
+    struct i2c_rdwr_ioctl_data rdwr = {
+        .msgs = messages,
+        .nmsgs = 2,
+    };
+    return ioctl(i2cdev->fd, I2C_RDWR, &rdwr);
+}
+
+struct i2c_backend_t const i2c_backend_i2cdev = {
+    .open = i2cI2cdevOpen,
+    .close = i2cI2cdevClose,
+    .write = i2cI2cdevWrite,
+    .read = i2cI2cdevRead,
+    .write_read = i2cI2cdevWriteRead,
+};
@@ -0,0 +1,54 @@
+#include <stdint.h>
+
+#include "interface/i2c.h"
+#include "pigpio.h"
+
+static int32_t i2cPigpioOpen(struct i2c_settings_t* settings, void** context) {
+    int32_t handle;
+    handle = i2cOpen(settings->bus_number, settings->address, 0x00);
+    if (handle < 0) {
+        return handle;
+    }
+    *context = (void*)(intptr_t)handle;
+    return 0;
+}
+
+static void i2cPigpioClose(void* context) {
+    i2cClose((uint32_t)(intptr_t)context);
+}
+
+static int32_t i2cPigpioWrite(void* context, uint8_t* tx_buffer,
+                              uint16_t length) {
+    return i2cWriteDevice((uint32_t)(intptr_t)context, (char*)tx_buffer,
+                          length);
+}
+
+static int32_t i2cPigpioRead(void* context, uint8_t* rx_buffer,
+                             uint16_t length) {
+    return i2cReadDevice((uint32_t)(intptr_t)context, (char*)rx_buffer,
+                         length);
+}
+
+static int32_t i2cPigpioWriteRead(void* context, uint8_t* tx_buffer,
+                                  uint16_t tx_length, uint8_t* rx_buffer,
+                                  uint16_t rx_length) {
+    uint32_t handle = (uint32_t)(intptr_t)context;
+    int32_t result;
+    if (tx_length == 1 && rx_length <= 32) {
+        return i2cReadI2CBlockData(handle, tx_buffer[0], (char*)rx_buffer,
+                                   rx_length);
+    }
+    result = i2cWriteDevice(handle, (char*)tx_buffer, tx_length);
+    if (result < 0) {
+        return result;
+    }
+    return i2cReadDevice(handle, (char*)rx_buffer, rx_length);
+}
+
+struct i2c_backend_t const i2c_backend_pigpio = {
+    .open = i2cPigpioOpen,
+    .close = i2cPigpioClose,
+    .write = i2cPigpioWrite,
+    .read = i2cPigpioRead,
+    .write_read = i2cPigpioWriteRead,
+};
@@ -1,29 +1,169 @@
 #include "interface/spi.h"
+#include <stddef.h>
 #include <stdint.h>
-#include "pigpio.h"
+#include <string.h>
+
+#include "utility/instrument.h"
+
+#define SPI_DEVICE_MAX 32
+
+struct spi_slot_t {
+    struct spi_backend_t const* backend;
+    void* context;
+    uint8_t bus_number;
+    uint8_t slave_number;
+};
+
+static struct spi_slot_t spi_slots[SPI_DEVICE_MAX];
+
+static int32_t spiTransferFrame(struct spi_backend_t const* backend,
+                                void* context, struct spi_segment_t* segments,
+                                uint8_t count);
+static inline uint32_t spiBatchLength(struct spi_segment_t* segments,
+                                      uint8_t count);
 
 spi_device_t spiInitialize(struct spi_settings_t* settings) {
-    uint32_t spi_flag = 0;
-    int8_t device;
-    spi_flag = settings->mode_number | settings->active_high
-                                           << settings->slave_number;
-    device = spiOpen(settings->slave_number, settings->clock_speed, spi_flag);
-    if (device >= 0) {
-        return (spi_device_t)device;
-    } else {
-        return 0;
+    struct spi_backend_t const* backend = settings->backend;
+    if (backend == NULL) {
+#ifdef PIGPIO_ENABLE
+        backend = &spi_backend_pigpio;
+#else
+        backend = &spi_backend_spidev;
+#endif
+    }
+    for (spi_device_t device = 1; device < SPI_DEVICE_MAX; device++) {
+        if (spi_slots[device].backend == NULL) {
+            if (backend->open(settings, &spi_slots[device].context) < 0) {
+                return 0;
+            }
+            spi_slots[device].backend = backend;
+            spi_slots[device].bus_number = settings->bus_number;
+            spi_slots[device].slave_number = settings->slave_number;
+            INSTRUMENT_ATTACH(instrument_interface_spi, device,
+                              settings->bus_number);
+            return device;
+        }
     }
+    return 0;
 }
 
 void spiFinalize(spi_device_t device) {
-    spiClose(device);
+    if (device == 0 || device >= SPI_DEVICE_MAX ||
+        spi_slots[device].backend == NULL) {
+        return;
+    }
+    spi_slots[device].backend->close(spi_slots[device].context);
+    spi_slots[device].backend = NULL;
+    spi_slots[device].context = NULL;
+}
+
+void* spiGetContext(spi_device_t device) {
+    return spi_slots[device % SPI_DEVICE_MAX].context;
+}
+
+struct spi_backend_t const* spiGetBackend(spi_device_t device) {
+    return spi_slots[device % SPI_DEVICE_MAX].backend;
+}
+
+uint8_t spiGetBusNumber(spi_device_t device) {
+    return spi_slots[device % SPI_DEVICE_MAX].bus_number;
+}
+
+uint8_t spiGetSlaveNumber(spi_device_t device) {
+    return spi_slots[device % SPI_DEVICE_MAX].slave_number;
 }
 
 void spiTransfer(spi_device_t device, uint8_t* tx_buffer, uint8_t* rx_buffer,
                  uint16_t length) {
-    if (rx_buffer == NULL) {
-        spiWrite(device, (char*)tx_buffer, length);
-    } else {
-        spiXfer(device, (char*)tx_buffer, (char*)rx_buffer, length);
+    struct spi_slot_t* slot = &spi_slots[device % SPI_DEVICE_MAX];
+    if (slot->backend == NULL) {
+        return;
+    }
+    INSTRUMENT_START(start);
+    int32_t result =
+        slot->backend->transfer(slot->context, tx_buffer, rx_buffer, length);
+    INSTRUMENT_TRANSACTION(instrument_interface_spi, device, length, result,
+                           start);
+}
+
+void spiTransferBatch(spi_device_t device, struct spi_segment_t* segments,
+                      uint8_t count) {
+    struct spi_slot_t* slot = &spi_slots[device % SPI_DEVICE_MAX];
+    if (slot->backend == NULL) {
+        return;
+    }
+    INSTRUMENT_START(start);
+    int32_t result = spiBackendTransferBatch(slot->backend, slot->context,
+                                             segments, count);
+    INSTRUMENT_TRANSACTION(instrument_interface_spi, device,
+                           spiBatchLength(segments, count), result, start);
+}
+
+int32_t spiBackendTransferBatch(struct spi_backend_t const* backend,
+                                void* context, struct spi_segment_t* segments,
+                                uint8_t count) {
+    if (backend->transfer_batch != NULL) {
+        return backend->transfer_batch(context, segments, count);
+    }
+    int32_t result = 0;
+    uint8_t first = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!segments[i].cs_change && i + 1 < count) {
+            continue;
+        }
+        int32_t frame_result;
+        if (first == i) {
+            frame_result =
+                backend->transfer(context, segments[i].tx_buffer,
+                                  segments[i].rx_buffer, segments[i].length);
+        } else {
+            frame_result = spiTransferFrame(backend, context, &segments[first],
+                                            i - first + 1);
+        }
+        if (frame_result < 0) {
+            result = frame_result;
+        }
+        first = i + 1;
+    }
+    return result;
+}
+
+static int32_t spiTransferFrame(struct spi_backend_t const* backend,
+                                void* context, struct spi_segment_t* segments,
+                                uint8_t count) {
+    uint32_t length = 0;
+    uint32_t offset = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        length += segments[i].length;
+    }
+    uint8_t tx_buffer[length];
+    uint8_t rx_buffer[length];
+    for (uint8_t i = 0; i < count; i++) {
+        if (segments[i].tx_buffer != NULL) {
+            memcpy(&tx_buffer[offset], segments[i].tx_buffer,
+                   segments[i].length);
+        } else {
+            memset(&tx_buffer[offset], 0x00, segments[i].length);
+        }
+        offset += segments[i].length;
+    }
+    int32_t result = backend->transfer(context, tx_buffer, rx_buffer, length);
+    offset = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (segments[i].rx_buffer != NULL) {
+            memcpy(segments[i].rx_buffer, &rx_buffer[offset],
+                   segments[i].length);
+        }
+        offset += segments[i].length;
+    }
+    return result;
+}
+
+static inline uint32_t spiBatchLength(struct spi_segment_t* segments,
+                                      uint8_t count) {
+    uint32_t length = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        length += segments[i].length;
     }
+    return length;
 }
@@ -0,0 +1,38 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "interface/spi.h"
+#include "pigpio.h"
+
+static int32_t spiPigpioOpen(struct spi_settings_t* settings, void** context) {
+    uint32_t spi_flag = 0;
+    int32_t handle;
+    spi_flag = settings->mode_number | settings->active_high
+                                           << settings->slave_number;
+    handle = spiOpen(settings->slave_number, settings->clock_speed, spi_flag);
+    if (handle < 0) {
+        return handle;
+    }
+    *context = (void*)(intptr_t)handle;
+    return 0;
+}
+
+static void spiPigpioClose(void* context) {
+    spiClose((uint32_t)(intptr_t)context);
+}
+
+static int32_t spiPigpioTransfer(void* context, uint8_t* tx_buffer,
+                                 uint8_t* rx_buffer, uint16_t length) {
+    uint32_t handle = (uint32_t)(intptr_t)context;
+    if (rx_buffer == NULL) {
+        return spiWrite(handle, (char*)tx_buffer, length);
+    } else {
+        return spiXfer(handle, (char*)tx_buffer, (char*)rx_buffer, length);
+    }
+}
+
+struct spi_backend_t const spi_backend_pigpio = {
+    .open = spiPigpioOpen,
+    .close = spiPigpioClose,
+    .transfer = spiPigpioTransfer,
+};
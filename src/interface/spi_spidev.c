@@ -0,0 +1,90 @@
+#include <fcntl.h>
+#include <linux/spi/spidev.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "interface/spi.h"
+
+struct spi_spidev_t {
+    int fd;
+    uint32_t clock_speed;
+};
+
+static int32_t spiSpidevOpen(struct spi_settings_t* settings, void** context) {
+    char path[32];
+    uint8_t mode = settings->mode_number & 0x03;
+    uint8_t bits = 8;
+    struct spi_spidev_t* spidev;
+    if (settings->active_high == spi_active_high_enable) {
+        mode |= SPI_CS_HIGH;
+    }
+    snprintf(path, sizeof(path), "/dev/spidev%u.%u", settings->bus_number,
+             settings->slave_number);
+    spidev = malloc(sizeof(struct spi_spidev_t));
+    if (spidev == NULL) {
+        return -1;
+    }
+    spidev->fd = open(path, O_RDWR);
+    spidev->clock_speed = settings->clock_speed;
+    if (spidev->fd < 0 || ioctl(spidev->fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+        ioctl(spidev->fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+        ioctl(spidev->fd, SPI_IOC_WR_MAX_SPEED_HZ, &spidev->clock_speed) < 0) {
+        if (spidev->fd >= 0) {
+            close(spidev->fd);
+        }
+        free(spidev);
+        return -1;
+    }
+    *context = spidev;
+    return 0;
+}
+
+static void spiSpidevClose(void* context) {
+    struct spi_spidev_t* spidev = context;
+    close(spidev->fd);
+    free(spidev);
+}
+
+static int32_t spiSpidevTransfer(void* context, uint8_t* tx_buffer,
+                                 uint8_t* rx_buffer, uint16_t length) {
+    struct spi_spidev_t* spidev = context;
+    struct spi_ioc_transfer transfer;
+    memset(&transfer, 0, sizeof(transfer));
+    transfer.tx_buf = (uintptr_t)tx_buffer;
+    transfer.rx_buf = (uintptr_t)rx_buffer;
+    transfer.len = length;
+    transfer.speed_hz = spidev->clock_speed;
+    transfer.bits_per_word = 8;
+    return ioctl(spidev->fd, SPI_IOC_MESSAGE(1), &transfer);
+}
+
+static int32_t spiSpidevTransferBatch(void* context,
+                                      struct spi_segment_t* segments,
+                                      uint8_t count) {
+    struct spi_spidev_t* spidev = context;
+    if (count == 0) {
+        return 0;
+    }
+    struct spi_ioc_transfer transfers[count];
+    memset(transfers, 0, sizeof(transfers));
+    for (uint8_t i = 0; i < count; i++) {
+        transfers[i].tx_buf = (uintptr_t)segments[i].tx_buffer;
+        transfers[i].rx_buf = (uintptr_t)segments[i].rx_buffer;
+        transfers[i].len = segments[i].length;
+        transfers[i].speed_hz = spidev->clock_speed;
+        transfers[i].bits_per_word = 8;
+        transfers[i].cs_change = i + 1 < count && segments[i].cs_change;
+    }
+    return ioctl(spidev->fd, SPI_IOC_MESSAGE(count), transfers);
+}
+
+struct spi_backend_t const spi_backend_spidev = {
+    .open = spiSpidevOpen,
+    .close = spiSpidevClose,
+    .transfer = spiSpidevTransfer,
+    .transfer_batch = spiSpidevTransferBatch,
+};
@@ -0,0 +1,619 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "interface/i2c.h"
+#include "interface/spi.h"
+#include "interface/trace.h"
+#include "utility/clock.h"
+
+static char const trace_magic[8] = "TRACE01";
+
+static uint8_t const trace_interface_spi = 0;
+static uint8_t const trace_interface_i2c = 1;
+
+struct trace_device_t {
+    struct trace_recorder_t* recorder;
+    struct spi_backend_t const* spi_backend;
+    struct i2c_backend_t const* i2c_backend;
+    void* context;
+    uint8_t device;
+};
+
+struct trace_cursor_t {
+    struct trace_replay_t* replay;
+    uint8_t interface;
+    uint8_t device;
+    uint32_t position;
+};
+
+static void traceWriteBegin(struct trace_device_t* device,
+                            enum trace_operation_t operation, uint64_t start,
+                            int32_t result, uint32_t length, uint16_t count);
+static void traceWriteBytes(struct trace_device_t* device,
+                            uint8_t const* buffer, uint16_t length);
+static void traceWriteLength(struct trace_device_t* device, uint16_t length);
+static void traceWriteEnd(struct trace_device_t* device);
+
+static int32_t traceReplayOpenDevice(struct trace_replay_t* replay,
+                                     uint8_t interface, void** context);
+static uint8_t* traceReplayNext(struct trace_cursor_t* cursor,
+                                enum trace_operation_t operation,
+                                struct trace_record_t* record);
+static uint16_t traceReadLength(uint8_t const* payload);
+static uint8_t traceRecordValid(struct trace_record_t const* record,
+                                uint8_t const* payload);
+static void traceReplayData(struct trace_cursor_t* cursor,
+                            uint8_t const* recorded_tx,
+                            uint16_t recorded_tx_length, uint8_t* tx_buffer,
+                            uint16_t tx_length, uint8_t const* recorded_rx,
+                            uint16_t recorded_rx_length, uint8_t* rx_buffer,
+                            uint16_t rx_length);
+
+int8_t traceRecorderOpen(struct trace_recorder_t* recorder, char const* path) {
+    recorder->stream = fopen(path, "wb");
+    if (recorder->stream == NULL) {
+        return -1;
+    }
+    if (fwrite(trace_magic, sizeof(trace_magic), 1, recorder->stream) != 1) {
+        fclose(recorder->stream);
+        return -1;
+    }
+    pthread_mutex_init(&recorder->mutex, NULL);
+    recorder->start_time = clockGetTime();
+    recorder->spi_devices = 0;
+    recorder->i2c_devices = 0;
+    return 0;
+}
+
+void traceRecorderClose(struct trace_recorder_t* recorder) {
+    fclose(recorder->stream);
+    pthread_mutex_destroy(&recorder->mutex);
+}
+
+static int32_t traceSpiOpen(struct spi_settings_t* settings, void** context) {
+    struct trace_settings_t* trace_settings = settings->backend_data;
+    struct spi_settings_t inner_settings = *settings;
+    struct trace_device_t* device;
+    if (trace_settings == NULL || trace_settings->spi_backend == NULL) {
+        return -1;
+    }
+    device = malloc(sizeof(struct trace_device_t));
+    if (device == NULL) {
+        return -1;
+    }
+    device->recorder = trace_settings->recorder;
+    device->spi_backend = trace_settings->spi_backend;
+    device->i2c_backend = NULL;
+    inner_settings.backend = trace_settings->spi_backend;
+    inner_settings.backend_data = trace_settings->backend_data;
+    uint64_t start = clockGetTime();
+    int32_t result =
+        device->spi_backend->open(&inner_settings, &device->context);
+    if (result < 0) {
+        free(device);
+        return result;
+    }
+    uint8_t open_data[2] = {settings->bus_number, settings->slave_number};
+    pthread_mutex_lock(&device->recorder->mutex);
+    if (device->recorder->spi_devices == TRACE_DEVICE_MAX) {
+        pthread_mutex_unlock(&device->recorder->mutex);
+        device->spi_backend->close(device->context);
+        free(device);
+        return -1;
+    }
+    device->device = device->recorder->spi_devices++;
+    pthread_mutex_unlock(&device->recorder->mutex);
+    traceWriteBegin(device, trace_operation_spi_open, start, result, 2, 0);
+    traceWriteBytes(device, open_data, 2);
+    traceWriteEnd(device);
+    *context = device;
+    return result;
+}
+
+static int32_t traceI2cOpen(struct i2c_settings_t* settings, void** context) {
+    struct trace_settings_t* trace_settings = settings->backend_data;
+    struct i2c_settings_t inner_settings = *settings;
+    struct trace_device_t* device;
+    if (trace_settings == NULL || trace_settings->i2c_backend == NULL) {
+        return -1;
+    }
+    device = malloc(sizeof(struct trace_device_t));
+    if (device == NULL) {
+        return -1;
+    }
+    device->recorder = trace_settings->recorder;
+    device->spi_backend = NULL;
+    device->i2c_backend = trace_settings->i2c_backend;
+    inner_settings.backend = trace_settings->i2c_backend;
+    inner_settings.backend_data = trace_settings->backend_data;
+    uint64_t start = clockGetTime();
+    int32_t result =
+        device->i2c_backend->open(&inner_settings, &device->context);
+    if (result < 0) {
+        free(device);
+        return result;
+    }
+    uint8_t open_data[2] = {settings->bus_number, settings->address};
+    pthread_mutex_lock(&device->recorder->mutex);
+    if (device->recorder->i2c_devices == TRACE_DEVICE_MAX) {
+        pthread_mutex_unlock(&device->recorder->mutex);
+        device->i2c_backend->close(device->context);
+        free(device);
+        return -1;
+    }
+    device->device = device->recorder->i2c_devices++;
+    pthread_mutex_unlock(&device->recorder->mutex);
+    traceWriteBegin(device, trace_operation_i2c_open, start, result, 2, 0);
+    traceWriteBytes(device, open_data, 2);
+    traceWriteEnd(device);
+    *context = device;
+    return result;
+}
+
+static void traceClose(void* context) {
+    struct trace_device_t* device = context;
+    if (device->spi_backend != NULL) {
+        device->spi_backend->close(device->context);
+    } else {
+        device->i2c_backend->close(device->context);
+    }
+    free(device);
+}
+
+static int32_t traceSpiTransfer(void* context, uint8_t* tx_buffer,
+                                uint8_t* rx_buffer, uint16_t length) {
+    struct trace_device_t* device = context;
+    uint8_t cs_change = 1;
+    uint64_t start = clockGetTime();
+    int32_t result = device->spi_backend->transfer(device->context, tx_buffer,
+                                                   rx_buffer, length);
+    traceWriteBegin(device, trace_operation_spi_transfer, start, result,
+                    3 + 2 * (uint32_t)length, 1);
+    traceWriteLength(device, length);
+    traceWriteBytes(device, &cs_change, 1);
+    traceWriteBytes(device, tx_buffer, length);
+    traceWriteBytes(device, rx_buffer, length);
+    traceWriteEnd(device);
+    return result;
+}
+
+static int32_t traceSpiTransferBatch(void* context,
+                                     struct spi_segment_t* segments,
+                                     uint8_t count) {
+    struct trace_device_t* device = context;
+    uint32_t length = 0;
+    uint64_t start = clockGetTime();
+    int32_t result = spiBackendTransferBatch(device->spi_backend,
+                                             device->context, segments, count);
+    for (uint8_t i = 0; i < count; i++) {
+        length += 3 + 2 * (uint32_t)segments[i].length;
+    }
+    traceWriteBegin(device, trace_operation_spi_transfer_batch, start, result,
+                    length, count);
+    for (uint8_t i = 0; i < count; i++) {
+        traceWriteLength(device, segments[i].length);
+        traceWriteBytes(device, &segments[i].cs_change, 1);
+        traceWriteBytes(device, segments[i].tx_buffer, segments[i].length);
+        traceWriteBytes(device, segments[i].rx_buffer, segments[i].length);
+    }
+    traceWriteEnd(device);
+    return result;
+}
+
+static void traceI2cRecord(struct trace_device_t* device,
+                           enum trace_operation_t operation, uint64_t start,
+                           int32_t result, uint8_t* tx_buffer,
+                           uint16_t tx_length, uint8_t* rx_buffer,
+                           uint16_t rx_length) {
+    traceWriteBegin(device, operation, start, result,
+                    4 + (uint32_t)tx_length + rx_length, 1);
+    traceWriteLength(device, tx_length);
+    traceWriteLength(device, rx_length);
+    traceWriteBytes(device, tx_buffer, tx_length);
+    traceWriteBytes(device, rx_buffer, rx_length);
+    traceWriteEnd(device);
+}
+
+static int32_t traceI2cWrite(void* context, uint8_t* tx_buffer,
+                             uint16_t length) {
+    struct trace_device_t* device = context;
+    uint64_t start = clockGetTime();
+    int32_t result =
+        device->i2c_backend->write(device->context, tx_buffer, length);
+    traceI2cRecord(device, trace_operation_i2c_write, start, result,
+                   tx_buffer, length, NULL, 0);
+    return result;
+}
+
+static int32_t traceI2cRead(void* context, uint8_t* rx_buffer,
+                            uint16_t length) {
+    struct trace_device_t* device = context;
+    uint64_t start = clockGetTime();
+    int32_t result =
+        device->i2c_backend->read(device->context, rx_buffer, length);
+    traceI2cRecord(device, trace_operation_i2c_read, start, result, NULL, 0,
+                   rx_buffer, length);
+    return result;
+}
+
+static int32_t traceI2cWriteRead(void* context, uint8_t* tx_buffer,
+                                 uint16_t tx_length, uint8_t* rx_buffer,
+                                 uint16_t rx_length) {
+    struct trace_device_t* device = context;
+    uint64_t start = clockGetTime();
+    int32_t result;
+    if (device->i2c_backend->write_read != NULL) {
+        result = device->i2c_backend->write_read(
+            device->context, tx_buffer, tx_length, rx_buffer, rx_length);
+    } else {
+        result = device->i2c_backend->write(device->context, tx_buffer,
+                                            tx_length);
+        int32_t read_result =
+            device->i2c_backend->read(device->context, rx_buffer, rx_length);
+        if (result >= 0) {
+            result = read_result;
+        }
+    }
+    traceI2cRecord(device, trace_operation_i2c_write_read, start, result,
+                   tx_buffer, tx_length, rx_buffer, rx_length);
+    return result;
+}
+
+struct spi_backend_t const trace_spi_backend = {
+    .open = traceSpiOpen,
+    .close = traceClose,
+    .transfer = traceSpiTransfer,
+    .transfer_batch = traceSpiTransferBatch,
+};
+
+struct i2c_backend_t const trace_i2c_backend = {
+    .open = traceI2cOpen,
+    .close = traceClose,
+    .write = traceI2cWrite,
+    .read = traceI2cRead,
+    .write_read = traceI2cWriteRead,
+};
+
+static void traceWriteBegin(struct trace_device_t* device,
+                            enum trace_operation_t operation, uint64_t start,
+                            int32_t result, uint32_t length, uint16_t count) {
+    uint64_t end = clockGetTime();
+    struct trace_record_t record = {
+        .time = start - device->recorder->start_time,
+        .duration = end - start,
+        .result = result,
+        .length = length,
+        .operation = operation,
+        .device = device->device,
+        .count = count,
+    };
+    pthread_mutex_lock(&device->recorder->mutex);
+    fwrite(&record, sizeof(record), 1, device->recorder->stream);
+}
+
+static void traceWriteBytes(struct trace_device_t* device,
+                            uint8_t const* buffer, uint16_t length) {
+    if (buffer != NULL) {
+        fwrite(buffer, 1, length, device->recorder->stream);
+        return;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        fputc(0x00, device->recorder->stream);
+    }
+}
+
+static void traceWriteLength(struct trace_device_t* device, uint16_t length) {
+    uint8_t data[2] = {length & 0xFF, length >> 8};
+    traceWriteBytes(device, data, 2);
+}
+
+static void traceWriteEnd(struct trace_device_t* device) {
+    pthread_mutex_unlock(&device->recorder->mutex);
+}
+
+int8_t traceReplayOpen(struct trace_replay_t* replay, char const* path,
+                       uint8_t paced) {
+    memset(replay, 0, sizeof(struct trace_replay_t));
+    FILE* stream = fopen(path, "rb");
+    if (stream == NULL) {
+        return -1;
+    }
+    fseek(stream, 0, SEEK_END);
+    long size = ftell(stream);
+    fseek(stream, 0, SEEK_SET);
+    if (size < (long)sizeof(trace_magic)) {
+        fclose(stream);
+        return -1;
+    }
+    replay->data = malloc(size);
+    replay->size = size;
+    if (replay->data == NULL ||
+        fread(replay->data, 1, size, stream) != (size_t)size ||
+        memcmp(replay->data, trace_magic, sizeof(trace_magic)) != 0) {
+        fclose(stream);
+        traceReplayClose(replay);
+        return -1;
+    }
+    fclose(stream);
+
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        size_t offset = sizeof(trace_magic);
+        while (offset + sizeof(struct trace_record_t) <= replay->size) {
+            struct trace_record_t record;
+            memcpy(&record, &replay->data[offset], sizeof(record));
+            if (offset + sizeof(record) + record.length > replay->size) {
+                break;
+            }
+            if (pass == 0 &&
+                !traceRecordValid(&record,
+                                  &replay->data[offset + sizeof(record)])) {
+                traceReplayClose(replay);
+                return -1;
+            }
+            uint8_t interface = record.operation >> 4;
+            uint8_t device = record.device;
+            if (interface <= trace_interface_i2c && device < TRACE_DEVICE_MAX) {
+                uint32_t* count = &replay->index_count[interface][device];
+                if (pass == 1) {
+                    replay->index[interface][device][*count] = offset;
+                }
+                (*count)++;
+            }
+            offset += sizeof(record) + record.length;
+        }
+        if (pass == 1) {
+            break;
+        }
+        for (uint8_t i = 0; i < 2; i++) {
+            for (uint8_t j = 0; j < TRACE_DEVICE_MAX; j++) {
+                if (replay->index_count[i][j] == 0) {
+                    continue;
+                }
+                replay->index[i][j] =
+                    malloc(replay->index_count[i][j] * sizeof(uint32_t));
+                if (replay->index[i][j] == NULL) {
+                    traceReplayClose(replay);
+                    return -1;
+                }
+                replay->index_count[i][j] = 0;
+            }
+        }
+    }
+    replay->paced = paced;
+    replay->start_time = clockGetTime();
+    return 0;
+}
+
+void traceReplayClose(struct trace_replay_t* replay) {
+    for (uint8_t i = 0; i < 2; i++) {
+        for (uint8_t j = 0; j < TRACE_DEVICE_MAX; j++) {
+            free(replay->index[i][j]);
+            replay->index[i][j] = NULL;
+        }
+    }
+    free(replay->data);
+    replay->data = NULL;
+}
+
+static int32_t traceReplaySpiOpen(struct spi_settings_t* settings,
+                                  void** context) {
+    return traceReplayOpenDevice(settings->backend_data, trace_interface_spi,
+                                 context);
+}
+
+static int32_t traceReplayI2cOpen(struct i2c_settings_t* settings,
+                                  void** context) {
+    return traceReplayOpenDevice(settings->backend_data, trace_interface_i2c,
+                                 context);
+}
+
+static void traceReplayCloseDevice(void* context) {
+    free(context);
+}
+
+static int32_t traceReplaySpiTransfer(void* context, uint8_t* tx_buffer,
+                                      uint8_t* rx_buffer, uint16_t length) {
+    struct trace_cursor_t* cursor = context;
+    struct trace_record_t record;
+    uint8_t* payload =
+        traceReplayNext(cursor, trace_operation_spi_transfer, &record);
+    if (payload == NULL) {
+        return -1;
+    }
+    uint16_t recorded_length = traceReadLength(payload);
+    traceReplayData(cursor, &payload[3], recorded_length, tx_buffer, length,
+                    &payload[3 + recorded_length], recorded_length, rx_buffer,
+                    length);
+    return record.result;
+}
+
+static int32_t traceReplaySpiTransferBatch(void* context,
+                                           struct spi_segment_t* segments,
+                                           uint8_t count) {
+    struct trace_cursor_t* cursor = context;
+    struct trace_record_t record;
+    uint8_t* payload =
+        traceReplayNext(cursor, trace_operation_spi_transfer_batch, &record);
+    if (payload == NULL) {
+        return -1;
+    }
+    if (record.count != count) {
+        atomic_fetch_add(&cursor->replay->mismatches, 1);
+    }
+    for (uint8_t i = 0; i < count && i < record.count; i++) {
+        uint16_t recorded_length = traceReadLength(payload);
+        traceReplayData(cursor, &payload[3], recorded_length,
+                        segments[i].tx_buffer, segments[i].length,
+                        &payload[3 + recorded_length], recorded_length,
+                        segments[i].rx_buffer, segments[i].length);
+        payload += 3 + 2 * (uint32_t)recorded_length;
+    }
+    return record.result;
+}
+
+static int32_t traceReplayI2c(void* context, enum trace_operation_t operation,
+                              uint8_t* tx_buffer, uint16_t tx_length,
+                              uint8_t* rx_buffer, uint16_t rx_length) {
+    struct trace_cursor_t* cursor = context;
+    struct trace_record_t record;
+    uint8_t* payload = traceReplayNext(cursor, operation, &record);
+    if (payload == NULL) {
+        return -1;
+    }
+    uint16_t recorded_tx_length = traceReadLength(payload);
+    uint16_t recorded_rx_length = traceReadLength(&payload[2]);
+    traceReplayData(cursor, &payload[4], recorded_tx_length, tx_buffer,
+                    tx_length, &payload[4 + recorded_tx_length],
+                    recorded_rx_length, rx_buffer, rx_length);
+    return record.result;
+}
+
+static int32_t traceReplayI2cWrite(void* context, uint8_t* tx_buffer,
+                                   uint16_t length) {
+    return traceReplayI2c(context, trace_operation_i2c_write, tx_buffer,
+                          length, NULL, 0);
+}
+
+static int32_t traceReplayI2cRead(void* context, uint8_t* rx_buffer,
+                                  uint16_t length) {
+    return traceReplayI2c(context, trace_operation_i2c_read, NULL, 0,
+                          rx_buffer, length);
+}
+
+static int32_t traceReplayI2cWriteRead(void* context, uint8_t* tx_buffer,
+                                       uint16_t tx_length, uint8_t* rx_buffer,
+                                       uint16_t rx_length) {
+    return traceReplayI2c(context, trace_operation_i2c_write_read, tx_buffer,
+                          tx_length, rx_buffer, rx_length);
+}
+
+struct spi_backend_t const trace_replay_spi_backend = {
+    .open = traceReplaySpiOpen,
+    .close = traceReplayCloseDevice,
+    .transfer = traceReplaySpiTransfer,
+    .transfer_batch = traceReplaySpiTransferBatch,
+};
+
+struct i2c_backend_t const trace_replay_i2c_backend = {
+    .open = traceReplayI2cOpen,
+    .close = traceReplayCloseDevice,
+    .write = traceReplayI2cWrite,
+    .read = traceReplayI2cRead,
+    .write_read = traceReplayI2cWriteRead,
+};
+
+static int32_t traceReplayOpenDevice(struct trace_replay_t* replay,
+                                     uint8_t interface, void** context) {
+    if (replay == NULL || replay->data == NULL) {
+        return -1;
+    }
+    uint8_t device = interface == trace_interface_spi
+                         ? atomic_fetch_add(&replay->spi_devices, 1)
+                         : atomic_fetch_add(&replay->i2c_devices, 1);
+    if (device >= TRACE_DEVICE_MAX) {
+        return -1;
+    }
+    struct trace_cursor_t* cursor = malloc(sizeof(struct trace_cursor_t));
+    if (cursor == NULL) {
+        return -1;
+    }
+    cursor->replay = replay;
+    cursor->interface = interface;
+    cursor->device = device;
+    cursor->position = 0;
+    struct trace_record_t record;
+    if (traceReplayNext(cursor, interface == trace_interface_spi
+                                    ? trace_operation_spi_open
+                                    : trace_operation_i2c_open,
+                        &record) == NULL) {
+        free(cursor);
+        return -1;
+    }
+    *context = cursor;
+    return record.result;
+}
+
+static uint8_t* traceReplayNext(struct trace_cursor_t* cursor,
+                                enum trace_operation_t operation,
+                                struct trace_record_t* record) {
+    struct trace_replay_t* replay = cursor->replay;
+    if (cursor->position >=
+        replay->index_count[cursor->interface][cursor->device]) {
+        atomic_fetch_add(&replay->mismatches, 1);
+        return NULL;
+    }
+    uint32_t offset =
+        replay->index[cursor->interface][cursor->device][cursor->position++];
+    memcpy(record, &replay->data[offset], sizeof(struct trace_record_t));
+    if (record->operation != operation) {
+        atomic_fetch_add(&replay->mismatches, 1);
+        return NULL;
+    }
+    if (replay->paced) {
+        clockSleepUntil(replay->start_time + record->time + record->duration);
+    }
+    atomic_fetch_add(&replay->transactions, 1);
+    return &replay->data[offset + sizeof(struct trace_record_t)];
+}
+
+static uint16_t traceReadLength(uint8_t const* payload) {
+    return payload[0] | payload[1] << 8;
+}
+
+// The lengths inside a payload must add up to the record length, or replay
+// would read past the record
+static uint8_t traceRecordValid(struct trace_record_t const* record,
+                                uint8_t const* payload) {
+    uint32_t length = 0;
+    switch (record->operation) {
+    case trace_operation_spi_open:
+    case trace_operation_i2c_open:
+        return record->length == 2;
+    case trace_operation_spi_transfer:
+    case trace_operation_spi_transfer_batch:
+        for (uint16_t i = 0; i < record->count; i++) {
+            if (record->length - length < 3) {
+                return 0;
+            }
+            length += 3 + 2 * (uint32_t)traceReadLength(&payload[length]);
+            if (length > record->length) {
+                return 0;
+            }
+        }
+        return length == record->length;
+    case trace_operation_i2c_write:
+    case trace_operation_i2c_read:
+    case trace_operation_i2c_write_read:
+        if (record->length < 4) {
+            return 0;
+        }
+        length = 4 + (uint32_t)traceReadLength(payload) +
+                 traceReadLength(&payload[2]);
+        return length == record->length;
+    default:
+        return 0;
+    }
+}
+
+static void traceReplayData(struct trace_cursor_t* cursor,
+                            uint8_t const* recorded_tx,
+                            uint16_t recorded_tx_length, uint8_t* tx_buffer,
+                            uint16_t tx_length, uint8_t const* recorded_rx,
+                            uint16_t recorded_rx_length, uint8_t* rx_buffer,
+                            uint16_t rx_length) {
+    if (recorded_tx_length != tx_length || recorded_rx_length != rx_length ||
+        (tx_buffer != NULL && memcmp(recorded_tx, tx_buffer, tx_length) != 0)) {
+        atomic_fetch_add(&cursor->replay->mismatches, 1);
+    }
+    if (rx_buffer != NULL) {
+        uint16_t length =
+            rx_length < recorded_rx_length ? rx_length : recorded_rx_length;
+        memcpy(rx_buffer, recorded_rx, length);
+        memset(&rx_buffer[length], 0x00, rx_length - length);
+    }
+}
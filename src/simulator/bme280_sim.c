@@ -0,0 +1,279 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "device/bme280.h"
+#include "interface/spi.h"
+#include "simulator/bme280_sim.h"
+#include "simulator/simulator.h"
+
+static uint8_t const bme280_sim_ctrl_hum_addr = 0xF2;
+static uint8_t const bme280_sim_status_addr = 0xF3;
+static uint8_t const bme280_sim_ctrl_meas_addr = 0xF4;
+static uint8_t const bme280_sim_config_addr = 0xF5;
+static uint8_t const bme280_sim_reset_addr = 0xE0;
+static uint8_t const bme280_sim_id_addr = 0xD0;
+static uint8_t const bme280_sim_data_addr = 0xF7;
+
+static uint8_t const bme280_sim_chip_id = 0x60;
+static uint8_t const bme280_sim_reset_command = 0xB6;
+static uint8_t const bme280_sim_status_update = 0x01;
+static uint8_t const bme280_sim_status_measuring = 0x08;
+
+static uint32_t const bme280_sim_default_reset_time = 2000;
+static uint32_t const bme280_sim_default_temperature = 519888;
+static uint32_t const bme280_sim_default_pressure = 415148;
+static uint32_t const bme280_sim_default_humidity = 30000;
+
+static uint8_t const bme280_sim_osr[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+static uint32_t const bme280_sim_standby_time[8] = {
+    500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000,
+};
+
+static struct bme280_calib_data_t const bme280_sim_default_calib_data = {
+    .dig_t1 = 27504,
+    .dig_t2 = 26435,
+    .dig_t3 = -1000,
+    .dig_p1 = 36477,
+    .dig_p2 = -10685,
+    .dig_p3 = 3024,
+    .dig_p4 = 2855,
+    .dig_p5 = 140,
+    .dig_p6 = -7,
+    .dig_p7 = 15500,
+    .dig_p8 = -14600,
+    .dig_p9 = 6000,
+    .dig_h1 = 75,
+    .dig_h2 = 370,
+    .dig_h3 = 0,
+    .dig_h4 = 312,
+    .dig_h5 = 50,
+    .dig_h6 = 30,
+};
+
+static void bme280SimWriteCalibData(struct bme280_sim_t* sim,
+                                    struct bme280_calib_data_t const* data);
+static void bme280SimReset(struct bme280_sim_t* sim, uint64_t now);
+static void bme280SimUpdate(struct bme280_sim_t* sim, uint64_t now);
+static void bme280SimLatch(struct bme280_sim_t* sim, uint64_t time);
+static void bme280SimSetReg(struct bme280_sim_t* sim, uint8_t address,
+                            uint8_t data, uint64_t now);
+static uint64_t bme280SimMeasurementTime(struct bme280_sim_t* sim);
+
+void bme280SimInitialize(struct bme280_sim_t* sim,
+                         struct bme280_sim_settings_t* settings) {
+    memset(sim, 0, sizeof(struct bme280_sim_t));
+    if (settings != NULL) {
+        sim->settings = *settings;
+    }
+    if (sim->settings.calib_data == NULL) {
+        sim->settings.calib_data = &bme280_sim_default_calib_data;
+    }
+    if (sim->settings.reset_time == 0) {
+        sim->settings.reset_time = bme280_sim_default_reset_time;
+    }
+    bme280SimWriteCalibData(sim, sim->settings.calib_data);
+    sim->reg[bme280_sim_id_addr] = bme280_sim_chip_id;
+    bme280SimReset(sim, 0);
+}
+
+static int32_t bme280SimOpen(struct spi_settings_t* settings, void** context) {
+    if (settings->backend_data == NULL) {
+        return -1;
+    }
+    *context = settings->backend_data;
+    return 0;
+}
+
+static void bme280SimClose(void* context) {
+    (void)context;
+}
+
+static int32_t bme280SimTransfer(void* context, uint8_t* tx_buffer,
+                                 uint8_t* rx_buffer, uint16_t length) {
+    struct bme280_sim_t* sim = context;
+    uint64_t now = simulatorGetTime();
+    bme280SimUpdate(sim, now);
+    if (length == 0) {
+        return 0;
+    }
+    if (tx_buffer[0] & 0x80) {
+        uint8_t address = tx_buffer[0];
+        if (rx_buffer != NULL) {
+            rx_buffer[0] = 0xFF;
+            for (uint16_t i = 1; i < length; i++) {
+                rx_buffer[i] = sim->reg[address++];
+            }
+        }
+    } else {
+        for (uint16_t i = 0; i + 1 < length; i += 2) {
+            bme280SimSetReg(sim, tx_buffer[i] | 0x80, tx_buffer[i + 1], now);
+        }
+        if (rx_buffer != NULL) {
+            memset(rx_buffer, 0xFF, length);
+        }
+    }
+    return length;
+}
+
+struct spi_backend_t const bme280_sim_backend = {
+    .open = bme280SimOpen,
+    .close = bme280SimClose,
+    .transfer = bme280SimTransfer,
+};
+
+static void bme280SimWriteCalibData(struct bme280_sim_t* sim,
+                                    struct bme280_calib_data_t const* data) {
+    uint16_t const temp_pres[12] = {
+        data->dig_t1,           (uint16_t)data->dig_t2, (uint16_t)data->dig_t3,
+        data->dig_p1,           (uint16_t)data->dig_p2, (uint16_t)data->dig_p3,
+        (uint16_t)data->dig_p4, (uint16_t)data->dig_p5, (uint16_t)data->dig_p6,
+        (uint16_t)data->dig_p7, (uint16_t)data->dig_p8, (uint16_t)data->dig_p9,
+    };
+    for (uint8_t i = 0; i < 12; i++) {
+        sim->reg[0x88 + i * 2] = temp_pres[i] & 0xFF;
+        sim->reg[0x89 + i * 2] = temp_pres[i] >> 8;
+    }
+    sim->reg[0xA1] = data->dig_h1;
+    sim->reg[0xE1] = (uint16_t)data->dig_h2 & 0xFF;
+    sim->reg[0xE2] = (uint16_t)data->dig_h2 >> 8;
+    sim->reg[0xE3] = data->dig_h3;
+    sim->reg[0xE4] = ((uint16_t)data->dig_h4 >> 4) & 0xFF;
+    sim->reg[0xE5] = (data->dig_h4 & 0x0F) | (data->dig_h5 & 0x0F) << 4;
+    sim->reg[0xE6] = ((uint16_t)data->dig_h5 >> 4) & 0xFF;
+    sim->reg[0xE7] = (uint8_t)data->dig_h6;
+}
+
+static void bme280SimReset(struct bme280_sim_t* sim, uint64_t now) {
+    sim->reg[bme280_sim_ctrl_hum_addr] = 0x00;
+    sim->reg[bme280_sim_ctrl_meas_addr] = 0x00;
+    sim->reg[bme280_sim_config_addr] = 0x00;
+    sim->reg[0xF7] = 0x80;
+    sim->reg[0xF8] = 0x00;
+    sim->reg[0xF9] = 0x00;
+    sim->reg[0xFA] = 0x80;
+    sim->reg[0xFB] = 0x00;
+    sim->reg[0xFC] = 0x00;
+    sim->reg[0xFD] = 0x80;
+    sim->reg[0xFE] = 0x00;
+    sim->osr_hum = 0;
+    sim->measurement_start = 0;
+    sim->measurement_end = 0;
+    sim->reset_end = now + (uint64_t)sim->settings.reset_time * 1000;
+}
+
+static void bme280SimUpdate(struct bme280_sim_t* sim, uint64_t now) {
+    uint8_t mode = sim->reg[bme280_sim_ctrl_meas_addr] & 0x03;
+    uint8_t status = 0x00;
+    if (now < sim->reset_end) {
+        status |= bme280_sim_status_update;
+    }
+    if (mode == bme280_mode_normal) {
+        uint64_t measurement_time = bme280SimMeasurementTime(sim);
+        uint64_t elapsed = now - sim->measurement_start;
+        uint64_t cycle = elapsed / sim->cycle_time;
+        uint64_t phase = elapsed % sim->cycle_time;
+        if (phase < measurement_time) {
+            status |= bme280_sim_status_measuring;
+            if (cycle > 0) {
+                bme280SimLatch(sim, sim->measurement_start +
+                                        (cycle - 1) * sim->cycle_time +
+                                        measurement_time);
+            }
+        } else {
+            bme280SimLatch(sim, sim->measurement_start +
+                                    cycle * sim->cycle_time + measurement_time);
+        }
+    } else if (sim->measurement_end != 0) {
+        if (now < sim->measurement_end) {
+            status |= bme280_sim_status_measuring;
+        } else {
+            bme280SimLatch(sim, sim->measurement_end);
+            sim->measurement_end = 0;
+            sim->reg[bme280_sim_ctrl_meas_addr] &= ~0x03;
+        }
+    }
+    sim->reg[bme280_sim_status_addr] = status;
+}
+
+static void bme280SimLatch(struct bme280_sim_t* sim, uint64_t time) {
+    uint8_t ctrl_meas = sim->reg[bme280_sim_ctrl_meas_addr];
+    uint32_t temperature = 0x80000;
+    uint32_t pressure = 0x80000;
+    uint32_t humidity = 0x8000;
+    if (ctrl_meas & 0xE0) {
+        temperature =
+            simulatorSampleWaveform(&sim->settings.temperature, time,
+                                    bme280_sim_default_temperature) &
+            0xFFFFF;
+    }
+    if (ctrl_meas & 0x1C) {
+        pressure = simulatorSampleWaveform(&sim->settings.pressure, time,
+                                           bme280_sim_default_pressure) &
+                   0xFFFFF;
+    }
+    if (sim->osr_hum) {
+        humidity = simulatorSampleWaveform(&sim->settings.humidity, time,
+                                           bme280_sim_default_humidity) &
+                   0xFFFF;
+    }
+    sim->reg[bme280_sim_data_addr + 0] = pressure >> 12;
+    sim->reg[bme280_sim_data_addr + 1] = (pressure >> 4) & 0xFF;
+    sim->reg[bme280_sim_data_addr + 2] = (pressure & 0x0F) << 4;
+    sim->reg[bme280_sim_data_addr + 3] = temperature >> 12;
+    sim->reg[bme280_sim_data_addr + 4] = (temperature >> 4) & 0xFF;
+    sim->reg[bme280_sim_data_addr + 5] = (temperature & 0x0F) << 4;
+    sim->reg[bme280_sim_data_addr + 6] = humidity >> 8;
+    sim->reg[bme280_sim_data_addr + 7] = humidity & 0xFF;
+}
+
+static void bme280SimSetReg(struct bme280_sim_t* sim, uint8_t address,
+                            uint8_t data, uint64_t now) {
+    if (address == bme280_sim_reset_addr) {
+        if (data == bme280_sim_reset_command) {
+            bme280SimReset(sim, now);
+        }
+    } else if (address == bme280_sim_ctrl_hum_addr) {
+        sim->reg[address] = data & 0x07;
+    } else if (address == bme280_sim_config_addr) {
+        sim->reg[address] = data & 0xFD;
+    } else if (address == bme280_sim_ctrl_meas_addr) {
+        uint8_t mode = sim->reg[address] & 0x03;
+        sim->reg[address] = data;
+        sim->osr_hum = sim->reg[bme280_sim_ctrl_hum_addr] & 0x07;
+        if ((data & 0x03) == bme280_mode_forced) {
+            sim->measurement_start = now;
+            sim->measurement_end = now + bme280SimMeasurementTime(sim);
+        } else if ((data & 0x03) == bme280_mode_normal) {
+            sim->measurement_end = 0;
+            sim->cycle_time =
+                bme280SimMeasurementTime(sim) +
+                (uint64_t)bme280_sim_standby_time
+                        [sim->reg[bme280_sim_config_addr] >> 5] *
+                    1000;
+            if (mode != bme280_mode_normal) {
+                sim->measurement_start = now;
+            }
+        } else {
+            sim->measurement_end = 0;
+        }
+    }
+}
+
+static uint64_t bme280SimMeasurementTime(struct bme280_sim_t* sim) {
+    uint8_t ctrl_meas = sim->reg[bme280_sim_ctrl_meas_addr];
+    uint8_t osr_temp = bme280_sim_osr[ctrl_meas >> 5];
+    uint8_t osr_pres = bme280_sim_osr[(ctrl_meas >> 2) & 0x07];
+    uint8_t osr_hum = bme280_sim_osr[sim->osr_hum];
+    uint64_t measurement_time = 1000 + 2000 * osr_temp;
+    if (sim->settings.measurement_time != 0) {
+        return (uint64_t)sim->settings.measurement_time * 1000;
+    }
+    if (osr_pres) {
+        measurement_time += 2000 * osr_pres + 500;
+    }
+    if (osr_hum) {
+        measurement_time += 2000 * osr_hum + 500;
+    }
+    return measurement_time * 1000;
+}
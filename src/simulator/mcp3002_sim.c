@@ -0,0 +1,132 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "interface/spi.h"
+#include "simulator/mcp3002_sim.h"
+#include "simulator/simulator.h"
+
+static uint32_t const mcp3002_sim_default_channel_0 = 512;
+static uint32_t const mcp3002_sim_default_channel_1 = 256;
+
+enum mcp3002_sim_state_t {
+    mcp3002_sim_state_start,
+    mcp3002_sim_state_sgl,
+    mcp3002_sim_state_odd,
+    mcp3002_sim_state_msbf,
+    mcp3002_sim_state_output,
+};
+
+static uint16_t mcp3002SimConvert(struct mcp3002_sim_t* sim, uint8_t sgl,
+                                  uint8_t odd, uint64_t time);
+
+void mcp3002SimInitialize(struct mcp3002_sim_t* sim,
+                          struct mcp3002_sim_settings_t* settings) {
+    memset(sim, 0, sizeof(struct mcp3002_sim_t));
+    if (settings != NULL) {
+        sim->settings = *settings;
+    }
+}
+
+static int32_t mcp3002SimOpen(struct spi_settings_t* settings,
+                              void** context) {
+    if (settings->backend_data == NULL) {
+        return -1;
+    }
+    *context = settings->backend_data;
+    return 0;
+}
+
+static void mcp3002SimClose(void* context) {
+    (void)context;
+}
+
+static int32_t mcp3002SimTransfer(void* context, uint8_t* tx_buffer,
+                                  uint8_t* rx_buffer, uint16_t length) {
+    struct mcp3002_sim_t* sim = context;
+    uint64_t now = simulatorGetTime();
+    enum mcp3002_sim_state_t state = mcp3002_sim_state_start;
+    uint8_t sgl = 0;
+    uint8_t odd = 0;
+    uint8_t msbf = 0;
+    uint16_t value = 0;
+    uint8_t clock = 0;
+    for (uint16_t i = 0; i < length; i++) {
+        uint8_t rx = 0x00;
+        for (int8_t bit = 7; bit >= 0; bit--) {
+            uint8_t din = (tx_buffer[i] >> bit) & 0x01;
+            uint8_t dout = 0x01;
+            switch (state) {
+            case mcp3002_sim_state_start:
+                if (din) {
+                    state = mcp3002_sim_state_sgl;
+                }
+                break;
+            case mcp3002_sim_state_sgl:
+                sgl = din;
+                state = mcp3002_sim_state_odd;
+                break;
+            case mcp3002_sim_state_odd:
+                odd = din;
+                state = mcp3002_sim_state_msbf;
+                break;
+            case mcp3002_sim_state_msbf:
+                msbf = din;
+                value = mcp3002SimConvert(sim, sgl, odd, now);
+                state = mcp3002_sim_state_output;
+                clock = 0;
+                break;
+            case mcp3002_sim_state_output:
+                if (clock == 0) {
+                    dout = 0x00;
+                } else if (clock <= 10) {
+                    dout = (value >> (10 - clock)) & 0x01;
+                } else if (!msbf && clock <= 19) {
+                    dout = (value >> (clock - 10)) & 0x01;
+                } else {
+                    dout = 0x00;
+                }
+                if (clock < 0xFF) {
+                    clock++;
+                }
+                break;
+            }
+            rx |= dout << bit;
+        }
+        if (rx_buffer != NULL) {
+            rx_buffer[i] = rx;
+        }
+    }
+    if (sim->settings.conversion_time != 0) {
+        while (simulatorGetTime() - now < sim->settings.conversion_time) {
+        }
+    }
+    return length;
+}
+
+struct spi_backend_t const mcp3002_sim_backend = {
+    .open = mcp3002SimOpen,
+    .close = mcp3002SimClose,
+    .transfer = mcp3002SimTransfer,
+};
+
+static uint16_t mcp3002SimConvert(struct mcp3002_sim_t* sim, uint8_t sgl,
+                                  uint8_t odd, uint64_t time) {
+    int32_t channel_0 = simulatorSampleWaveform(
+        &sim->settings.channel_0, time, mcp3002_sim_default_channel_0);
+    int32_t channel_1 = simulatorSampleWaveform(
+        &sim->settings.channel_1, time, mcp3002_sim_default_channel_1);
+    int32_t value;
+    sim->conversions++;
+    if (sgl) {
+        value = odd ? channel_1 : channel_0;
+    } else {
+        value = odd ? channel_1 - channel_0 : channel_0 - channel_1;
+    }
+    if (value < 0) {
+        value = 0;
+    } else if (value > 0x3FF) {
+        value = 0x3FF;
+    }
+    return (uint16_t)value;
+}
@@ -0,0 +1,25 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simulator/simulator.h"
+#include "utility/clock.h"
+
+uint64_t simulatorGetTime(void) {
+    return clockGetTime();
+}
+
+uint32_t simulatorSampleWaveform(struct simulator_waveform_t* waveform,
+                                 uint64_t time, uint32_t value) {
+    if (waveform->sample == NULL) {
+        return value;
+    }
+    return waveform->sample(waveform->context, time);
+}
+
+uint32_t simulatorSine(void* context, uint64_t time) {
+    struct simulator_sine_t* sine = context;
+    double phase = 2.0 * M_PI * sine->frequency * (time % 1000000000) / 1e9;
+    double value = sine->offset + sine->amplitude * sin(phase);
+    return value < 0.0 ? 0 : (uint32_t)value;
+}
@@ -0,0 +1,160 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "interface/i2c.h"
+#include "simulator/simulator.h"
+#include "simulator/tsl2561_sim.h"
+
+static uint8_t const tsl2561_sim_control_addr = 0x00;
+static uint8_t const tsl2561_sim_timing_addr = 0x01;
+static uint8_t const tsl2561_sim_id_addr = 0x0A;
+static uint8_t const tsl2561_sim_data_addr = 0x0C;
+
+static uint8_t const tsl2561_sim_command = 0x80;
+static uint8_t const tsl2561_sim_power_on = 0x03;
+static uint8_t const tsl2561_sim_gain_16x = 0x10;
+static uint8_t const tsl2561_sim_manual = 0x08;
+static uint8_t const tsl2561_sim_part_id = 0x50;
+
+static uint32_t const tsl2561_sim_default_channel_0 = 12000;
+static uint32_t const tsl2561_sim_default_channel_1 = 4000;
+
+static uint32_t const tsl2561_sim_integration_time[3] = {13700, 101000,
+                                                         402000};
+static uint32_t const tsl2561_sim_clip[3] = {5047, 37177, 65535};
+
+static void tsl2561SimUpdate(struct tsl2561_sim_t* sim, uint64_t now);
+static uint32_t tsl2561SimConvert(struct tsl2561_sim_t* sim,
+                                  struct simulator_waveform_t* waveform,
+                                  uint32_t value, uint64_t time);
+static uint64_t tsl2561SimIntegrationTime(struct tsl2561_sim_t* sim);
+
+void tsl2561SimInitialize(struct tsl2561_sim_t* sim,
+                          struct tsl2561_sim_settings_t* settings) {
+    memset(sim, 0, sizeof(struct tsl2561_sim_t));
+    if (settings != NULL) {
+        sim->settings = *settings;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        if (sim->settings.integration_time[i] == 0) {
+            sim->settings.integration_time[i] =
+                tsl2561_sim_integration_time[i];
+        }
+    }
+    sim->reg[tsl2561_sim_timing_addr] = 0x02;
+    sim->reg[tsl2561_sim_id_addr] = tsl2561_sim_part_id;
+}
+
+static int32_t tsl2561SimOpen(struct i2c_settings_t* settings, void** context) {
+    if (settings->backend_data == NULL) {
+        return -1;
+    }
+    *context = settings->backend_data;
+    return 0;
+}
+
+static void tsl2561SimClose(void* context) {
+    (void)context;
+}
+
+static int32_t tsl2561SimWrite(void* context, uint8_t* tx_buffer,
+                               uint16_t length) {
+    struct tsl2561_sim_t* sim = context;
+    uint64_t now = simulatorGetTime();
+    tsl2561SimUpdate(sim, now);
+    if (length == 0 || !(tx_buffer[0] & tsl2561_sim_command)) {
+        return -1;
+    }
+    sim->pointer = tx_buffer[0] & 0x0F;
+    for (uint16_t i = 1; i < length; i++) {
+        uint8_t address = sim->pointer;
+        if (address == tsl2561_sim_control_addr) {
+            uint8_t power = sim->reg[address] & 0x03;
+            sim->reg[address] = tx_buffer[i] & 0x03;
+            if (power != tsl2561_sim_power_on &&
+                sim->reg[address] == tsl2561_sim_power_on) {
+                sim->integration_start = now;
+                memset(&sim->reg[tsl2561_sim_data_addr], 0, 4);
+            }
+        } else if (address == tsl2561_sim_timing_addr) {
+            sim->reg[address] = tx_buffer[i] & 0x1B;
+            sim->integration_start = now;
+        } else if (address < tsl2561_sim_id_addr) {
+            sim->reg[address] = tx_buffer[i];
+        }
+        sim->pointer = (sim->pointer + 1) & 0x0F;
+    }
+    return length;
+}
+
+static int32_t tsl2561SimRead(void* context, uint8_t* rx_buffer,
+                              uint16_t length) {
+    struct tsl2561_sim_t* sim = context;
+    tsl2561SimUpdate(sim, simulatorGetTime());
+    for (uint16_t i = 0; i < length; i++) {
+        rx_buffer[i] = sim->reg[sim->pointer];
+        sim->pointer = (sim->pointer + 1) & 0x0F;
+    }
+    return length;
+}
+
+struct i2c_backend_t const tsl2561_sim_backend = {
+    .open = tsl2561SimOpen,
+    .close = tsl2561SimClose,
+    .write = tsl2561SimWrite,
+    .read = tsl2561SimRead,
+};
+
+static void tsl2561SimUpdate(struct tsl2561_sim_t* sim, uint64_t now) {
+    uint64_t integration_time;
+    uint64_t windows;
+    uint64_t end;
+    uint32_t channel_0;
+    uint32_t channel_1;
+    if ((sim->reg[tsl2561_sim_control_addr] & 0x03) != tsl2561_sim_power_on ||
+        (sim->reg[tsl2561_sim_timing_addr] & tsl2561_sim_manual)) {
+        return;
+    }
+    integration_time = tsl2561SimIntegrationTime(sim);
+    windows = (now - sim->integration_start) / integration_time;
+    if (windows == 0) {
+        return;
+    }
+    end = sim->integration_start + windows * integration_time;
+    channel_0 = tsl2561SimConvert(sim, &sim->settings.channel_0,
+                                  tsl2561_sim_default_channel_0, end);
+    channel_1 = tsl2561SimConvert(sim, &sim->settings.channel_1,
+                                  tsl2561_sim_default_channel_1, end);
+    sim->reg[tsl2561_sim_data_addr + 0] = channel_0 & 0xFF;
+    sim->reg[tsl2561_sim_data_addr + 1] = channel_0 >> 8;
+    sim->reg[tsl2561_sim_data_addr + 2] = channel_1 & 0xFF;
+    sim->reg[tsl2561_sim_data_addr + 3] = channel_1 >> 8;
+}
+
+static uint32_t tsl2561SimConvert(struct tsl2561_sim_t* sim,
+                                  struct simulator_waveform_t* waveform,
+                                  uint32_t value, uint64_t time) {
+    uint8_t integral = sim->reg[tsl2561_sim_timing_addr] & 0x03;
+    uint64_t count = simulatorSampleWaveform(waveform, time, value);
+    if (integral > 2) {
+        integral = 2;
+    }
+    count = count * tsl2561_sim_integration_time[integral] /
+            tsl2561_sim_integration_time[2];
+    if (!(sim->reg[tsl2561_sim_timing_addr] & tsl2561_sim_gain_16x)) {
+        count /= 16;
+    }
+    if (count > tsl2561_sim_clip[integral]) {
+        count = tsl2561_sim_clip[integral];
+    }
+    return (uint32_t)count;
+}
+
+static uint64_t tsl2561SimIntegrationTime(struct tsl2561_sim_t* sim) {
+    uint8_t integral = sim->reg[tsl2561_sim_timing_addr] & 0x03;
+    if (integral > 2) {
+        integral = 2;
+    }
+    return (uint64_t)sim->settings.integration_time[integral] * 1000;
+}
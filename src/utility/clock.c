@@ -0,0 +1,24 @@
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "utility/clock.h"
+
+uint64_t clockGetTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void clockSleepUntil(uint64_t time) {
+    if (time <= clockGetTime()) {
+        return;
+    }
+    struct timespec deadline = {
+        .tv_sec = time / 1000000000,
+        .tv_nsec = time % 1000000000,
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) ==
+           EINTR) {
+    }
+}
@@ -0,0 +1,192 @@
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "device/bme280.h"
+#include "device/tsl2561.h"
+#include "interface/i2c.h"
+#include "interface/spi.h"
+#include "utility/clock.h"
+#include "utility/fleet.h"
+
+static uint64_t const fleet_default_timeout = 100000000;
+static uint64_t const fleet_poll_time = 1000000;
+
+struct fleet_bus_t {
+    struct fleet_device_t* devices;
+    uint8_t const* group;
+    uint32_t count;
+    uint8_t index;
+    struct bme280_cache_t* bme280_cache;
+    uint64_t timeout;
+    uint64_t start_time;
+    pthread_t thread;
+};
+
+static void* fleetRunBus(void* argument);
+static void fleetStartDevice(struct fleet_bus_t* bus,
+                             struct fleet_device_t* device);
+static void fleetFinishDevice(struct fleet_bus_t* bus,
+                              struct fleet_device_t* device);
+static uint16_t fleetGetBusKey(struct fleet_device_t* device);
+
+uint64_t fleetInitialize(struct fleet_device_t* devices, uint32_t count,
+                         struct fleet_settings_t* settings) {
+    uint64_t start_time = clockGetTime();
+    struct fleet_bus_t buses[FLEET_BUS_MAX];
+    uint16_t keys[FLEET_BUS_MAX];
+    uint8_t bus_count = 0;
+    uint8_t* group = malloc(count ? count : 1);
+    struct bme280_cache_t* bme280_cache = settings ? settings->bme280_cache
+                                                   : NULL;
+    struct bme280_cache_t* bus_caches = NULL;
+    if (group == NULL) {
+        return 0;
+    }
+
+    // Group devices by bus, buses beyond the limit share the last group
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t key = fleetGetBusKey(&devices[i]);
+        uint8_t index = 0;
+        while (index < bus_count && keys[index] != key) {
+            index++;
+        }
+        if (index == bus_count && bus_count < FLEET_BUS_MAX) {
+            keys[bus_count++] = key;
+        }
+        group[i] = index < bus_count ? index : bus_count - 1;
+        devices[i].status = fleet_status_pending;
+        devices[i].ready_time = 0;
+        devices[i].time = 0;
+    }
+
+    // Each bus works on its own copy of the cache so no lock is held across
+    // SPI transfers, the copies are merged back once every bus is done
+    if (bme280_cache != NULL && bus_count != 0) {
+        bus_caches = malloc(bus_count * sizeof(struct bme280_cache_t));
+        if (bus_caches == NULL) {
+            free(group);
+            return 0;
+        }
+    }
+    for (uint8_t i = 0; i < bus_count; i++) {
+        buses[i].devices = devices;
+        buses[i].group = group;
+        buses[i].count = count;
+        buses[i].index = i;
+        buses[i].bme280_cache = NULL;
+        if (bus_caches != NULL) {
+            memcpy(&bus_caches[i], bme280_cache, sizeof(struct bme280_cache_t));
+            buses[i].bme280_cache = &bus_caches[i];
+        }
+        buses[i].timeout = settings && settings->timeout
+                               ? settings->timeout
+                               : fleet_default_timeout;
+        buses[i].start_time = start_time;
+    }
+
+    // Bring up every bus but the first on its own thread
+    uint8_t started[FLEET_BUS_MAX] = {0};
+    for (uint8_t i = 1; i < bus_count; i++) {
+        started[i] = pthread_create(&buses[i].thread, NULL, fleetRunBus,
+                                    &buses[i]) == 0;
+    }
+    for (uint8_t i = 0; i < bus_count; i++) {
+        if (!started[i]) {
+            fleetRunBus(&buses[i]);
+        }
+    }
+    for (uint8_t i = 1; i < bus_count; i++) {
+        if (started[i]) {
+            pthread_join(buses[i].thread, NULL);
+        }
+    }
+    for (uint8_t i = 0; bus_caches != NULL && i < bus_count; i++) {
+        bme280CacheMerge(bme280_cache, &bus_caches[i]);
+    }
+    free(bus_caches);
+    free(group);
+    return clockGetTime() - start_time;
+}
+
+static void* fleetRunBus(void* argument) {
+    struct fleet_bus_t* bus = argument;
+    uint64_t ready_time = 0;
+    for (uint32_t i = 0; i < bus->count; i++) {
+        if (bus->group[i] != bus->index) {
+            continue;
+        }
+        fleetStartDevice(bus, &bus->devices[i]);
+        if (bus->devices[i].status == fleet_status_pending &&
+            bus->devices[i].ready_time > ready_time) {
+            ready_time = bus->devices[i].ready_time;
+        }
+    }
+    clockSleepUntil(ready_time);
+    for (uint32_t i = 0; i < bus->count; i++) {
+        if (bus->group[i] == bus->index &&
+            bus->devices[i].status == fleet_status_pending) {
+            fleetFinishDevice(bus, &bus->devices[i]);
+        }
+    }
+    return NULL;
+}
+
+static void fleetStartDevice(struct fleet_bus_t* bus,
+                             struct fleet_device_t* device) {
+    int8_t result = -1;
+    switch (device->type) {
+    case fleet_device_bme280:
+        result = bme280StartInitialize(device->device, device->spi_device,
+                                       bus->bme280_cache,
+                                       &device->ready_time);
+        break;
+    case fleet_device_tsl2561:
+        result = tsl2561StartInitialize(device->device, device->i2c_device,
+                                        &device->ready_time);
+        break;
+    }
+    if (result < 0) {
+        device->status = fleet_status_missing;
+    } else if (result > 0) {
+        device->status = fleet_status_cached;
+    }
+    if (device->status != fleet_status_pending) {
+        device->time = clockGetTime() - bus->start_time;
+    }
+}
+
+static void fleetFinishDevice(struct fleet_bus_t* bus,
+                              struct fleet_device_t* device) {
+    uint64_t deadline = device->ready_time + bus->timeout;
+    int8_t result = -1;
+    while (1) {
+        switch (device->type) {
+        case fleet_device_bme280:
+            result = bme280FinishInitialize(device->device, bus->bme280_cache);
+            break;
+        case fleet_device_tsl2561:
+            result = tsl2561FinishInitialize(device->device);
+            break;
+        }
+        uint64_t now = clockGetTime();
+        if (result == 0 || now >= deadline) {
+            break;
+        }
+        clockSleepUntil(now + fleet_poll_time);
+    }
+    device->status = result == 0 ? fleet_status_ready : fleet_status_timeout;
+    device->time = clockGetTime() - bus->start_time;
+}
+
+static uint16_t fleetGetBusKey(struct fleet_device_t* device) {
+    switch (device->type) {
+    case fleet_device_bme280:
+        return spiGetBusNumber(device->spi_device);
+    case fleet_device_tsl2561:
+        return 0x100 | i2cGetBusNumber(device->i2c_device);
+    }
+    return 0;
+}
@@ -0,0 +1,343 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+#include "utility/hub.h"
+#include "utility/hub_protocol.h"
+#include "utility/sample.h"
+#include "utility/scheduler.h"
+
+static int const hub_listen_backlog = 16;
+
+static struct hub_device_t* hubAddDevice(struct hub_t* hub,
+                                         uint32_t device_id,
+                                         enum sample_type_t type);
+static struct hub_device_t* hubFindDevice(struct hub_t* hub,
+                                          uint32_t device_id);
+static void hubUpdatePeriod(struct hub_t* hub, uint32_t device_id);
+static void hubDeliver(struct scheduler_task_t* task);
+static void hubAccept(struct scheduler_watch_t* watch, uint32_t events);
+static void hubReceive(struct scheduler_watch_t* watch, uint32_t events);
+static void hubHandleRequest(struct hub_connection_t* connection,
+                             struct hub_request_t* request);
+static void hubSend(struct hub_connection_t* connection);
+static void hubCloseConnection(struct hub_connection_t* connection);
+
+int8_t hubInitialize(struct hub_t* hub, struct scheduler_t* scheduler,
+                     char const* path) {
+    struct sockaddr_un address = {
+        .sun_family = AF_UNIX,
+    };
+    memset(hub, 0, sizeof(struct hub_t));
+    hub->scheduler = scheduler;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    strcpy(hub->path, path);
+
+    // Sequenced packets keep one frame per message on a local socket
+    hub->watch.fd = socket(AF_UNIX,
+                           SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (hub->watch.fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    if (bind(hub->watch.fd, (struct sockaddr*)&address, sizeof(address)) !=
+            0 ||
+        listen(hub->watch.fd, hub_listen_backlog) != 0) {
+        close(hub->watch.fd);
+        return -1;
+    }
+    hub->watch.events = EPOLLIN;
+    hub->watch.callback = hubAccept;
+    hub->watch.context = hub;
+    if (schedulerAddWatch(scheduler, &hub->watch) != 0) {
+        close(hub->watch.fd);
+        unlink(path);
+        return -1;
+    }
+    return 0;
+}
+
+void hubFinalize(struct hub_t* hub) {
+    for (uint32_t i = 0; i < HUB_CONNECTION_MAX; i++) {
+        if (hub->connections[i].active) {
+            hubCloseConnection(&hub->connections[i]);
+        }
+    }
+    schedulerRemoveWatch(hub->scheduler, &hub->watch);
+    close(hub->watch.fd);
+    unlink(hub->path);
+}
+
+int8_t hubAddBme280(struct hub_t* hub, uint32_t device_id,
+                    struct bme280_t* device) {
+    struct hub_device_t* hub_device =
+        hubAddDevice(hub, device_id, sample_type_bme280);
+    if (hub_device == NULL) {
+        return -1;
+    }
+    schedulerInitializeBme280Task(&hub_device->task, device,
+                                  &hub_device->data.bme280, 0);
+    hub_device->task.callback = hubDeliver;
+    hub_device->task.context = hub_device;
+    schedulerAddTask(hub->scheduler, &hub_device->task);
+    return 0;
+}
+
+int8_t hubAddTsl2561(struct hub_t* hub, uint32_t device_id,
+                     struct tsl2561_t* device) {
+    struct hub_device_t* hub_device =
+        hubAddDevice(hub, device_id, sample_type_tsl2561);
+    if (hub_device == NULL) {
+        return -1;
+    }
+    schedulerInitializeTsl2561Task(&hub_device->task, device,
+                                   &hub_device->data.tsl2561, 0);
+    hub_device->task.callback = hubDeliver;
+    hub_device->task.context = hub_device;
+    schedulerAddTask(hub->scheduler, &hub_device->task);
+    return 0;
+}
+
+int8_t hubAddMcp3002(struct hub_t* hub, uint32_t device_id,
+                     struct mcp3002_t* device) {
+    struct hub_device_t* hub_device =
+        hubAddDevice(hub, device_id, sample_type_mcp3002);
+    if (hub_device == NULL) {
+        return -1;
+    }
+    schedulerInitializeMcp3002Task(&hub_device->task, device,
+                                   &hub_device->data.mcp3002, 0);
+    hub_device->task.callback = hubDeliver;
+    hub_device->task.context = hub_device;
+    schedulerAddTask(hub->scheduler, &hub_device->task);
+    return 0;
+}
+
+static struct hub_device_t* hubAddDevice(struct hub_t* hub,
+                                         uint32_t device_id,
+                                         enum sample_type_t type) {
+    if (hub->device_count == HUB_DEVICE_MAX ||
+        hubFindDevice(hub, device_id) != NULL) {
+        return NULL;
+    }
+    struct hub_device_t* device = &hub->devices[hub->device_count++];
+    device->hub = hub;
+    device->device_id = device_id;
+    device->type = type;
+    return device;
+}
+
+static struct hub_device_t* hubFindDevice(struct hub_t* hub,
+                                          uint32_t device_id) {
+    for (uint32_t i = 0; i < hub->device_count; i++) {
+        if (hub->devices[i].device_id == device_id) {
+            return &hub->devices[i];
+        }
+    }
+    return NULL;
+}
+
+static void hubUpdatePeriod(struct hub_t* hub, uint32_t device_id) {
+    struct hub_device_t* device = hubFindDevice(hub, device_id);
+    uint64_t period = 0;
+    if (device == NULL) {
+        return;
+    }
+
+    // Sample at the fastest rate any subscriber asked for, or not at all
+    for (uint32_t i = 0; i < HUB_CONNECTION_MAX; i++) {
+        struct hub_connection_t* connection = &hub->connections[i];
+        for (uint32_t j = 0; connection->active &&
+                             j < connection->subscription_count;
+             j++) {
+            struct hub_subscription_t* subscription =
+                &connection->subscriptions[j];
+            if (subscription->device_id == device_id &&
+                (period == 0 || subscription->period < period)) {
+                period = subscription->period;
+            }
+        }
+    }
+    if (period != device->task.period) {
+        schedulerSetTaskPeriod(&device->task, period);
+    }
+}
+
+static void hubDeliver(struct scheduler_task_t* task) {
+    struct hub_device_t* device = task->context;
+    struct hub_t* hub = device->hub;
+    uint64_t timestamp = task->last_start;
+    uint64_t tolerance = task->period / 2;
+    for (uint32_t i = 0; i < HUB_CONNECTION_MAX; i++) {
+        struct hub_connection_t* connection = &hub->connections[i];
+        for (uint32_t j = 0; connection->active &&
+                             j < connection->subscription_count;
+             j++) {
+            struct hub_subscription_t* subscription =
+                &connection->subscriptions[j];
+            if (subscription->device_id != device->device_id ||
+                timestamp + tolerance < subscription->next_time) {
+                continue;
+            }
+
+            // Decimate to the subscriber's own rate
+            subscription->next_time += subscription->period;
+            if (subscription->next_time <= timestamp) {
+                subscription->next_time = timestamp + subscription->period;
+            }
+            struct sample_t* sample =
+                &connection->frame.samples[connection->frame.count++];
+            sample->timestamp = timestamp;
+            sample->device_id = device->device_id;
+            sample->type = device->type;
+            memcpy(&sample->data, &device->data, sizeof(device->data));
+            if (connection->frame.count >= connection->batch) {
+                hubSend(connection);
+            }
+        }
+    }
+}
+
+static void hubAccept(struct scheduler_watch_t* watch, uint32_t events) {
+    struct hub_t* hub = watch->context;
+    (void)events;
+    for (;;) {
+        int fd = accept4(watch->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct hub_connection_t* connection = NULL;
+        for (uint32_t i = 0; i < HUB_CONNECTION_MAX; i++) {
+            if (!hub->connections[i].active) {
+                connection = &hub->connections[i];
+                break;
+            }
+        }
+        if (connection == NULL) {
+            close(fd);
+            continue;
+        }
+        memset(connection, 0, offsetof(struct hub_connection_t, frame));
+        connection->frames = 0;
+        connection->dropped = 0;
+        connection->watch.fd = fd;
+        connection->watch.events = EPOLLIN;
+        connection->watch.callback = hubReceive;
+        connection->watch.context = connection;
+        connection->hub = hub;
+        connection->batch = 1;
+        connection->frame.type = hub_message_samples;
+        connection->frame.count = 0;
+        if (schedulerAddWatch(hub->scheduler, &connection->watch) != 0) {
+            close(fd);
+            continue;
+        }
+        connection->active = 1;
+    }
+}
+
+static void hubReceive(struct scheduler_watch_t* watch, uint32_t events) {
+    struct hub_connection_t* connection = watch->context;
+    struct hub_request_t request;
+
+    // Events queued for a connection that has since closed are stale
+    (void)events;
+    while (connection->active) {
+        ssize_t length = recv(watch->fd, &request, sizeof(request), 0);
+        if (length > 0) {
+            if (length == sizeof(request)) {
+                hubHandleRequest(connection, &request);
+            }
+            continue;
+        }
+        if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        hubCloseConnection(connection);
+    }
+}
+
+static void hubHandleRequest(struct hub_connection_t* connection,
+                             struct hub_request_t* request) {
+    struct hub_t* hub = connection->hub;
+    uint32_t index = 0;
+    while (index < connection->subscription_count &&
+           connection->subscriptions[index].device_id != request->device_id) {
+        index++;
+    }
+    switch (request->type) {
+    case hub_message_subscribe:
+        if (request->period == 0 ||
+            hubFindDevice(hub, request->device_id) == NULL ||
+            index == HUB_SUBSCRIPTION_MAX) {
+            return;
+        }
+        if (index == connection->subscription_count) {
+            connection->subscription_count++;
+        }
+        connection->subscriptions[index].device_id = request->device_id;
+        connection->subscriptions[index].period = request->period;
+        connection->subscriptions[index].next_time = 0;
+        connection->batch = request->batch == 0 ? 1
+                            : request->batch > HUB_BATCH_MAX
+                                ? HUB_BATCH_MAX
+                                : request->batch;
+        if (connection->frame.count >= connection->batch) {
+            hubSend(connection);
+        }
+        break;
+    case hub_message_unsubscribe:
+        if (index == connection->subscription_count) {
+            return;
+        }
+        connection->subscriptions[index] =
+            connection->subscriptions[--connection->subscription_count];
+        break;
+    default:
+        return;
+    }
+    hubUpdatePeriod(hub, request->device_id);
+}
+
+static void hubSend(struct hub_connection_t* connection) {
+    size_t length = offsetof(struct hub_frame_t, samples) +
+                    connection->frame.count * sizeof(struct sample_t);
+
+    // Never block the sampling loop on a slow client, drop its frame instead
+    ssize_t sent = send(connection->watch.fd, &connection->frame, length,
+                        MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent == (ssize_t)length) {
+        connection->frames++;
+    } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        connection->dropped += connection->frame.count;
+    } else {
+        hubCloseConnection(connection);
+        return;
+    }
+    connection->frame.count = 0;
+}
+
+static void hubCloseConnection(struct hub_connection_t* connection) {
+    struct hub_t* hub = connection->hub;
+    schedulerRemoveWatch(hub->scheduler, &connection->watch);
+    close(connection->watch.fd);
+    connection->active = 0;
+    for (uint32_t i = 0; i < connection->subscription_count; i++) {
+        hubUpdatePeriod(hub, connection->subscriptions[i].device_id);
+    }
+    connection->subscription_count = 0;
+    connection->frame.count = 0;
+}
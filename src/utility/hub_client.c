@@ -0,0 +1,90 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "utility/hub_client.h"
+#include "utility/hub_protocol.h"
+#include "utility/sample.h"
+
+static int8_t hubClientRequest(struct hub_client_t* client,
+                               struct hub_request_t* request);
+
+int8_t hubClientOpen(struct hub_client_t* client, char const* path) {
+    struct sockaddr_un address = {
+        .sun_family = AF_UNIX,
+    };
+    client->fd = -1;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    client->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (client->fd < 0) {
+        return -1;
+    }
+    if (connect(client->fd, (struct sockaddr*)&address, sizeof(address)) !=
+        0) {
+        hubClientClose(client);
+        return -1;
+    }
+    return 0;
+}
+
+void hubClientClose(struct hub_client_t* client) {
+    if (client->fd >= 0) {
+        close(client->fd);
+    }
+    client->fd = -1;
+}
+
+int8_t hubClientSubscribe(struct hub_client_t* client, uint32_t device_id,
+                          uint64_t period, uint32_t batch) {
+    struct hub_request_t request = {
+        .type = hub_message_subscribe,
+        .device_id = device_id,
+        .period = period,
+        .batch = batch,
+    };
+    return hubClientRequest(client, &request);
+}
+
+int8_t hubClientUnsubscribe(struct hub_client_t* client, uint32_t device_id) {
+    struct hub_request_t request = {
+        .type = hub_message_unsubscribe,
+        .device_id = device_id,
+    };
+    return hubClientRequest(client, &request);
+}
+
+int32_t hubClientRead(struct hub_client_t* client, struct sample_t* samples,
+                      uint32_t count) {
+    // Samples land in the caller's buffer without an intermediate frame
+    struct hub_frame_t header;
+    struct iovec iov[2] = {
+        {&header, offsetof(struct hub_frame_t, samples)},
+        {samples, count * sizeof(struct sample_t)},
+    };
+    struct msghdr message = {
+        .msg_iov = iov,
+        .msg_iovlen = 2,
+    };
+    ssize_t length = recvmsg(client->fd, &message, 0);
+    if (length < (ssize_t)offsetof(struct hub_frame_t, samples) ||
+        header.type != hub_message_samples) {
+        return -1;
+    }
+    return header.count < count ? header.count : count;
+}
+
+static int8_t hubClientRequest(struct hub_client_t* client,
+                               struct hub_request_t* request) {
+    if (send(client->fd, request, sizeof(struct hub_request_t),
+             MSG_NOSIGNAL) != sizeof(struct hub_request_t)) {
+        return -1;
+    }
+    return 0;
+}
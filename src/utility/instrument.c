@@ -0,0 +1,198 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "utility/clock.h"
+#include "utility/instrument.h"
+
+struct instrument_record_t {
+    _Atomic uint64_t transactions;
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t errors;
+    _Atomic uint64_t polls;
+    _Atomic uint64_t delay_time;
+    _Atomic uint64_t latency[INSTRUMENT_BUCKET_MAX];
+};
+
+static struct instrument_record_t instrument_bus[instrument_interface_max]
+                                                [INSTRUMENT_BUS_MAX];
+static struct instrument_record_t instrument_device[instrument_interface_max]
+                                                   [INSTRUMENT_DEVICE_MAX];
+static _Atomic uint8_t instrument_device_bus[instrument_interface_max]
+                                            [INSTRUMENT_DEVICE_MAX];
+
+static char const* const instrument_interface_name[instrument_interface_max] = {
+    "spi", "i2c"};
+
+static void instrumentAdd(_Atomic uint64_t* counter, uint64_t value);
+static uint8_t instrumentBucket(uint64_t time);
+static void instrumentRead(struct instrument_record_t* record,
+                           struct instrument_counter_t* counter);
+static void instrumentClear(struct instrument_record_t* record);
+static void instrumentPrint(FILE* stream, char const* interface,
+                            char const* kind, uint8_t index,
+                            struct instrument_counter_t* counter);
+
+void instrumentAttach(enum instrument_interface_t interface, uint8_t device,
+                      uint8_t bus_number) {
+    if (interface >= instrument_interface_max ||
+        device >= INSTRUMENT_DEVICE_MAX) {
+        return;
+    }
+    atomic_store_explicit(&instrument_device_bus[interface][device],
+                          bus_number, memory_order_relaxed);
+    instrumentClear(&instrument_device[interface][device]);
+}
+
+void instrumentTransaction(enum instrument_interface_t interface,
+                           uint8_t device, uint32_t bytes, int32_t result,
+                           uint64_t start) {
+    if (interface >= instrument_interface_max ||
+        device >= INSTRUMENT_DEVICE_MAX) {
+        return;
+    }
+    uint8_t bucket = instrumentBucket(clockGetTime() - start);
+    uint8_t bus_number = atomic_load_explicit(
+        &instrument_device_bus[interface][device], memory_order_relaxed);
+    struct instrument_record_t* records[2] = {
+        &instrument_device[interface][device],
+        bus_number < INSTRUMENT_BUS_MAX ? &instrument_bus[interface][bus_number]
+                                        : NULL,
+    };
+    for (uint8_t i = 0; i < 2 && records[i] != NULL; i++) {
+        instrumentAdd(&records[i]->transactions, 1);
+        instrumentAdd(&records[i]->bytes, bytes);
+        if (result < 0) {
+            instrumentAdd(&records[i]->errors, 1);
+        }
+        instrumentAdd(&records[i]->latency[bucket], 1);
+    }
+}
+
+void instrumentPoll(enum instrument_interface_t interface, uint8_t device) {
+    if (interface >= instrument_interface_max ||
+        device >= INSTRUMENT_DEVICE_MAX) {
+        return;
+    }
+    uint8_t bus_number = atomic_load_explicit(
+        &instrument_device_bus[interface][device], memory_order_relaxed);
+    instrumentAdd(&instrument_device[interface][device].polls, 1);
+    if (bus_number < INSTRUMENT_BUS_MAX) {
+        instrumentAdd(&instrument_bus[interface][bus_number].polls, 1);
+    }
+}
+
+void instrumentDelay(enum instrument_interface_t interface, uint8_t device,
+                     uint64_t start) {
+    if (interface >= instrument_interface_max ||
+        device >= INSTRUMENT_DEVICE_MAX) {
+        return;
+    }
+    uint64_t time = clockGetTime() - start;
+    uint8_t bus_number = atomic_load_explicit(
+        &instrument_device_bus[interface][device], memory_order_relaxed);
+    instrumentAdd(&instrument_device[interface][device].delay_time, time);
+    if (bus_number < INSTRUMENT_BUS_MAX) {
+        instrumentAdd(&instrument_bus[interface][bus_number].delay_time, time);
+    }
+}
+
+void instrumentSnapshot(struct instrument_snapshot_t* snapshot) {
+    for (uint8_t i = 0; i < instrument_interface_max; i++) {
+        for (uint8_t j = 0; j < INSTRUMENT_BUS_MAX; j++) {
+            instrumentRead(&instrument_bus[i][j], &snapshot->bus[i][j]);
+        }
+        for (uint8_t j = 0; j < INSTRUMENT_DEVICE_MAX; j++) {
+            instrumentRead(&instrument_device[i][j], &snapshot->device[i][j]);
+            snapshot->device_bus[i][j] = atomic_load_explicit(
+                &instrument_device_bus[i][j], memory_order_relaxed);
+        }
+    }
+}
+
+void instrumentReset(void) {
+    for (uint8_t i = 0; i < instrument_interface_max; i++) {
+        for (uint8_t j = 0; j < INSTRUMENT_BUS_MAX; j++) {
+            instrumentClear(&instrument_bus[i][j]);
+        }
+        for (uint8_t j = 0; j < INSTRUMENT_DEVICE_MAX; j++) {
+            instrumentClear(&instrument_device[i][j]);
+        }
+    }
+}
+
+void instrumentDump(FILE* stream) {
+    static struct instrument_snapshot_t snapshot;
+    instrumentSnapshot(&snapshot);
+    for (uint8_t i = 0; i < instrument_interface_max; i++) {
+        for (uint8_t j = 0; j < INSTRUMENT_BUS_MAX; j++) {
+            instrumentPrint(stream, instrument_interface_name[i], "bus", j,
+                            &snapshot.bus[i][j]);
+        }
+        for (uint8_t j = 0; j < INSTRUMENT_DEVICE_MAX; j++) {
+            instrumentPrint(stream, instrument_interface_name[i], "device", j,
+                            &snapshot.device[i][j]);
+        }
+    }
+}
+
+static void instrumentAdd(_Atomic uint64_t* counter, uint64_t value) {
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+static uint8_t instrumentBucket(uint64_t time) {
+    uint8_t bucket = 63 - __builtin_clzll(time | 1);
+    return bucket < INSTRUMENT_BUCKET_MAX ? bucket : INSTRUMENT_BUCKET_MAX - 1;
+}
+
+static void instrumentRead(struct instrument_record_t* record,
+                           struct instrument_counter_t* counter) {
+    counter->transactions =
+        atomic_load_explicit(&record->transactions, memory_order_relaxed);
+    counter->bytes = atomic_load_explicit(&record->bytes, memory_order_relaxed);
+    counter->errors =
+        atomic_load_explicit(&record->errors, memory_order_relaxed);
+    counter->polls = atomic_load_explicit(&record->polls, memory_order_relaxed);
+    counter->delay_time =
+        atomic_load_explicit(&record->delay_time, memory_order_relaxed);
+    for (uint8_t i = 0; i < INSTRUMENT_BUCKET_MAX; i++) {
+        counter->latency[i] =
+            atomic_load_explicit(&record->latency[i], memory_order_relaxed);
+    }
+}
+
+static void instrumentClear(struct instrument_record_t* record) {
+    atomic_store_explicit(&record->transactions, 0, memory_order_relaxed);
+    atomic_store_explicit(&record->bytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&record->errors, 0, memory_order_relaxed);
+    atomic_store_explicit(&record->polls, 0, memory_order_relaxed);
+    atomic_store_explicit(&record->delay_time, 0, memory_order_relaxed);
+    for (uint8_t i = 0; i < INSTRUMENT_BUCKET_MAX; i++) {
+        atomic_store_explicit(&record->latency[i], 0, memory_order_relaxed);
+    }
+}
+
+static void instrumentPrint(FILE* stream, char const* interface,
+                            char const* kind, uint8_t index,
+                            struct instrument_counter_t* counter) {
+    if (counter->transactions == 0 && counter->polls == 0 &&
+        counter->delay_time == 0) {
+        return;
+    }
+    fprintf(stream,
+            "%s %s %u: transactions %llu bytes %llu errors %llu polls %llu "
+            "delay_ns %llu\n",
+            interface, kind, index, (unsigned long long)counter->transactions,
+            (unsigned long long)counter->bytes,
+            (unsigned long long)counter->errors,
+            (unsigned long long)counter->polls,
+            (unsigned long long)counter->delay_time);
+    for (uint8_t i = 0; i < INSTRUMENT_BUCKET_MAX; i++) {
+        if (counter->latency[i] != 0) {
+            fprintf(stream, "  latency < %llu ns: %llu\n",
+                    (unsigned long long)2 << i,
+                    (unsigned long long)counter->latency[i]);
+        }
+    }
+}
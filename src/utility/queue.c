@@ -0,0 +1,174 @@
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "utility/queue.h"
+#include "utility/sample.h"
+
+static uint32_t const queue_capacity_max = 1u << 31;
+
+static uint32_t queueCapacity(uint32_t capacity);
+static void* queueAllocate(uint32_t count, size_t size);
+
+int8_t spscQueueInitialize(struct spsc_queue_t* queue, uint32_t capacity) {
+    if (capacity > queue_capacity_max) {
+        return -1;
+    }
+    capacity = queueCapacity(capacity);
+    queue->buffer = queueAllocate(capacity, sizeof(struct sample_t));
+    if (queue->buffer == NULL) {
+        return -1;
+    }
+    queue->mask = capacity - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->tail_cache = 0;
+    queue->head_cache = 0;
+    return 0;
+}
+
+void spscQueueFinalize(struct spsc_queue_t* queue) {
+    free(queue->buffer);
+    queue->buffer = NULL;
+}
+
+uint32_t spscQueuePush(struct spsc_queue_t* queue,
+                       struct sample_t const* samples, uint32_t count) {
+    uint64_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint64_t free_count = queue->mask + 1 - (head - queue->tail_cache);
+    if (free_count < count) {
+        queue->tail_cache =
+            atomic_load_explicit(&queue->tail, memory_order_acquire);
+        free_count = queue->mask + 1 - (head - queue->tail_cache);
+        if (free_count < count) {
+            count = (uint32_t)free_count;
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        queue->buffer[(head + i) & queue->mask] = samples[i];
+    }
+    atomic_store_explicit(&queue->head, head + count, memory_order_release);
+    return count;
+}
+
+uint32_t spscQueuePop(struct spsc_queue_t* queue, struct sample_t* samples,
+                      uint32_t count) {
+    uint64_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint64_t used_count = queue->head_cache - tail;
+    if (used_count < count) {
+        queue->head_cache =
+            atomic_load_explicit(&queue->head, memory_order_acquire);
+        used_count = queue->head_cache - tail;
+        if (used_count < count) {
+            count = (uint32_t)used_count;
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        samples[i] = queue->buffer[(tail + i) & queue->mask];
+    }
+    atomic_store_explicit(&queue->tail, tail + count, memory_order_release);
+    return count;
+}
+
+int8_t mpscQueueInitialize(struct mpsc_queue_t* queue, uint32_t capacity) {
+    if (capacity > queue_capacity_max) {
+        return -1;
+    }
+    capacity = queueCapacity(capacity);
+    queue->cells = queueAllocate(capacity, sizeof(struct mpsc_cell_t));
+    if (queue->cells == NULL) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < capacity; i++) {
+        atomic_init(&queue->cells[i].sequence, i);
+    }
+    queue->mask = capacity - 1;
+    atomic_init(&queue->head, 0);
+    queue->tail = 0;
+    return 0;
+}
+
+void mpscQueueFinalize(struct mpsc_queue_t* queue) {
+    free(queue->cells);
+    queue->cells = NULL;
+}
+
+uint32_t mpscQueuePush(struct mpsc_queue_t* queue,
+                       struct sample_t const* samples, uint32_t count) {
+    uint64_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint32_t reserved;
+    do {
+        uint32_t low = 0;
+        uint32_t high = count < queue->mask + 1 ? count : queue->mask + 1;
+        while (low < high) {
+            uint32_t middle = (low + high + 1) / 2;
+            uint64_t position = head + middle - 1;
+            uint64_t sequence =
+                atomic_load_explicit(&queue->cells[position & queue->mask]
+                                          .sequence,
+                                     memory_order_acquire);
+            if (sequence == position) {
+                low = middle;
+            } else {
+                high = middle - 1;
+            }
+        }
+        reserved = low;
+        if (reserved == 0) {
+            uint64_t current =
+                atomic_load_explicit(&queue->head, memory_order_relaxed);
+            if (current == head) {
+                return 0;
+            }
+            head = current;
+            continue;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(
+        &queue->head, &head, head + reserved, memory_order_relaxed,
+        memory_order_relaxed));
+    for (uint32_t i = 0; i < reserved; i++) {
+        struct mpsc_cell_t* cell = &queue->cells[(head + i) & queue->mask];
+        cell->sample = samples[i];
+        atomic_store_explicit(&cell->sequence, head + i + 1,
+                              memory_order_release);
+    }
+    return reserved;
+}
+
+uint32_t mpscQueuePop(struct mpsc_queue_t* queue, struct sample_t* samples,
+                      uint32_t count) {
+    uint32_t popped = 0;
+    while (popped < count) {
+        struct mpsc_cell_t* cell = &queue->cells[queue->tail & queue->mask];
+        uint64_t sequence =
+            atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        if (sequence != queue->tail + 1) {
+            break;
+        }
+        samples[popped++] = cell->sample;
+        atomic_store_explicit(&cell->sequence, queue->tail + queue->mask + 1,
+                              memory_order_release);
+        queue->tail++;
+    }
+    return popped;
+}
+
+static uint32_t queueCapacity(uint32_t capacity) {
+    uint32_t power = 1;
+    while (power < capacity) {
+        power <<= 1;
+    }
+    return power;
+}
+
+// aligned_alloc wants the size to be a multiple of the alignment
+static void* queueAllocate(uint32_t count, size_t size) {
+    size_t length = (size_t)count * size;
+    if (length / size != count || length > SIZE_MAX - QUEUE_CACHE_LINE) {
+        return NULL;
+    }
+    length = (length + QUEUE_CACHE_LINE - 1) &
+             ~((size_t)QUEUE_CACHE_LINE - 1);
+    return aligned_alloc(QUEUE_CACHE_LINE, length);
+}
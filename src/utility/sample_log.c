@@ -0,0 +1,532 @@
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+#include "utility/sample.h"
+#include "utility/sample_log.h"
+
+static char const sample_log_magic[4] = {'S', 'L', 'O', 'G'};
+static uint8_t const sample_log_version = 1;
+
+static uint32_t const sample_log_file_header_size = 18;
+static uint32_t const sample_log_block_header_size = 24;
+static uint32_t const sample_log_varint_max = 10;
+
+static uint8_t const sample_log_bme280_settings_size = 39;
+static uint8_t const sample_log_tsl2561_settings_size = 3;
+static uint8_t const sample_log_mcp3002_settings_size = 8;
+
+static uint8_t sampleLogGetFieldCount(enum sample_type_t type);
+static int8_t sampleLogWriteBlock(struct sample_log_writer_t* writer);
+static int8_t sampleLogIndexBlocks(struct sample_log_reader_t* reader,
+                                   size_t offset);
+
+static inline uint8_t* sampleLogPutVarint(uint8_t* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+static inline uint8_t const* sampleLogGetVarint(uint8_t const* in,
+                                                uint8_t const* end,
+                                                uint64_t* value) {
+    uint64_t result = 0;
+    for (uint8_t shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t byte = *in++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return in;
+        }
+    }
+    return NULL;
+}
+
+static inline uint64_t sampleLogZigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t sampleLogUnzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static void sampleLogPut16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static void sampleLogPut32(uint8_t* out, uint32_t value) {
+    sampleLogPut16(out, value & 0xFFFF);
+    sampleLogPut16(&out[2], value >> 16);
+}
+
+static void sampleLogPut64(uint8_t* out, uint64_t value) {
+    sampleLogPut32(out, value & 0xFFFFFFFF);
+    sampleLogPut32(&out[4], value >> 32);
+}
+
+static uint16_t sampleLogGet16(uint8_t const* in) {
+    return in[0] | in[1] << 8;
+}
+
+static uint32_t sampleLogGet32(uint8_t const* in) {
+    return sampleLogGet16(in) | (uint32_t)sampleLogGet16(&in[2]) << 16;
+}
+
+static uint64_t sampleLogGet64(uint8_t const* in) {
+    return sampleLogGet32(in) | (uint64_t)sampleLogGet32(&in[4]) << 32;
+}
+
+void sampleLogHeaderFromBme280(struct sample_log_header_t* header,
+                               uint32_t device_id,
+                               struct bme280_t const* device) {
+    struct bme280_calib_data_t const* calib = &device->calib_data;
+    int16_t const calib_word[12] = {
+        (int16_t)calib->dig_t1, calib->dig_t2, calib->dig_t3,
+        (int16_t)calib->dig_p1, calib->dig_p2, calib->dig_p3,
+        calib->dig_p4,          calib->dig_p5, calib->dig_p6,
+        calib->dig_p7,          calib->dig_p8, calib->dig_p9,
+    };
+    uint8_t* out = header->settings;
+    memset(header, 0, sizeof(struct sample_log_header_t));
+    header->type = sample_type_bme280;
+    header->device_id = device_id;
+    header->settings_size = sample_log_bme280_settings_size;
+    for (uint8_t i = 0; i < 12; i++) {
+        sampleLogPut16(&out[i * 2], (uint16_t)calib_word[i]);
+    }
+    out[24] = calib->dig_h1;
+    sampleLogPut16(&out[25], (uint16_t)calib->dig_h2);
+    out[27] = calib->dig_h3;
+    sampleLogPut16(&out[28], (uint16_t)calib->dig_h4);
+    sampleLogPut16(&out[30], (uint16_t)calib->dig_h5);
+    out[32] = (uint8_t)calib->dig_h6;
+    out[33] = device->settings.mode;
+    out[34] = device->settings.osr_temp;
+    out[35] = device->settings.osr_pres;
+    out[36] = device->settings.osr_hum;
+    out[37] = device->settings.standby;
+    out[38] = device->settings.filter;
+}
+
+void sampleLogHeaderFromTsl2561(struct sample_log_header_t* header,
+                                uint32_t device_id,
+                                struct tsl2561_t const* device) {
+    memset(header, 0, sizeof(struct sample_log_header_t));
+    header->type = sample_type_tsl2561;
+    header->device_id = device_id;
+    header->settings_size = sample_log_tsl2561_settings_size;
+    header->settings[0] = device->settings.gain;
+    header->settings[1] = device->settings.integral;
+    header->settings[2] = device->settings.mode;
+}
+
+void sampleLogHeaderFromMcp3002(struct sample_log_header_t* header,
+                                uint32_t device_id,
+                                struct mcp3002_t const* device) {
+    memset(header, 0, sizeof(struct sample_log_header_t));
+    header->type = sample_type_mcp3002;
+    header->device_id = device_id;
+    header->settings_size = sample_log_mcp3002_settings_size;
+    // Stored as the bits of a double so both builds keep the full value
+    double base_voltage = device->settings.base_voltage;
+    uint64_t bits;
+    memcpy(&bits, &base_voltage, sizeof(bits));
+    sampleLogPut64(header->settings, bits);
+}
+
+int8_t sampleLogHeaderToBme280(struct sample_log_header_t const* header,
+                               struct bme280_t* device) {
+    struct bme280_calib_data_t* calib = &device->calib_data;
+    uint8_t const* in = header->settings;
+    if (header->type != sample_type_bme280 ||
+        header->settings_size < sample_log_bme280_settings_size) {
+        return -1;
+    }
+    memset(device, 0, sizeof(struct bme280_t));
+    calib->dig_t1 = sampleLogGet16(&in[0]);
+    calib->dig_t2 = (int16_t)sampleLogGet16(&in[2]);
+    calib->dig_t3 = (int16_t)sampleLogGet16(&in[4]);
+    calib->dig_p1 = sampleLogGet16(&in[6]);
+    calib->dig_p2 = (int16_t)sampleLogGet16(&in[8]);
+    calib->dig_p3 = (int16_t)sampleLogGet16(&in[10]);
+    calib->dig_p4 = (int16_t)sampleLogGet16(&in[12]);
+    calib->dig_p5 = (int16_t)sampleLogGet16(&in[14]);
+    calib->dig_p6 = (int16_t)sampleLogGet16(&in[16]);
+    calib->dig_p7 = (int16_t)sampleLogGet16(&in[18]);
+    calib->dig_p8 = (int16_t)sampleLogGet16(&in[20]);
+    calib->dig_p9 = (int16_t)sampleLogGet16(&in[22]);
+    calib->dig_h1 = in[24];
+    calib->dig_h2 = (int16_t)sampleLogGet16(&in[25]);
+    calib->dig_h3 = in[27];
+    calib->dig_h4 = (int16_t)sampleLogGet16(&in[28]);
+    calib->dig_h5 = (int16_t)sampleLogGet16(&in[30]);
+    calib->dig_h6 = (int8_t)in[32];
+    device->settings.mode = in[33];
+    device->settings.osr_temp = in[34];
+    device->settings.osr_pres = in[35];
+    device->settings.osr_hum = in[36];
+    device->settings.standby = in[37];
+    device->settings.filter = in[38];
+    bme280PrepareCompensation(device);
+    return 0;
+}
+
+int8_t sampleLogHeaderToTsl2561(struct sample_log_header_t const* header,
+                                struct tsl2561_t* device) {
+    if (header->type != sample_type_tsl2561 ||
+        header->settings_size < sample_log_tsl2561_settings_size) {
+        return -1;
+    }
+    memset(device, 0, sizeof(struct tsl2561_t));
+    device->settings.gain = header->settings[0];
+    device->settings.integral = header->settings[1];
+    device->settings.mode = header->settings[2];
+    return 0;
+}
+
+int8_t sampleLogHeaderToMcp3002(struct sample_log_header_t const* header,
+                                struct mcp3002_t* device) {
+    if (header->type != sample_type_mcp3002 ||
+        header->settings_size < sample_log_mcp3002_settings_size) {
+        return -1;
+    }
+    memset(device, 0, sizeof(struct mcp3002_t));
+    uint64_t bits = sampleLogGet64(header->settings);
+    double base_voltage;
+    memcpy(&base_voltage, &bits, sizeof(base_voltage));
+#ifdef MCP3002_FLOAT_ENABLE
+    device->settings.base_voltage = base_voltage;
+#else
+    device->settings.base_voltage = (uint32_t)(base_voltage + 0.5);
+#endif
+    return 0;
+}
+
+int8_t sampleLogWriterOpen(struct sample_log_writer_t* writer,
+                           char const* path,
+                           struct sample_log_header_t const* header) {
+    uint8_t file_header[sample_log_file_header_size];
+    memset(writer, 0, sizeof(struct sample_log_writer_t));
+    writer->field_count = sampleLogGetFieldCount(header->type);
+    if (writer->field_count == 0 ||
+        header->settings_size > SAMPLE_LOG_SETTINGS_MAX) {
+        return -1;
+    }
+    writer->header = *header;
+    writer->timestamp = malloc(SAMPLE_LOG_BLOCK_SAMPLES * sizeof(uint64_t));
+    writer->buffer = malloc(
+        sample_log_block_header_size +
+        (1 + writer->field_count) * sizeof(uint32_t) +
+        SAMPLE_LOG_BLOCK_SAMPLES * sample_log_varint_max *
+            (1 + writer->field_count));
+    for (uint8_t i = 0; i < writer->field_count; i++) {
+        writer->field[i] = malloc(SAMPLE_LOG_BLOCK_SAMPLES * sizeof(uint32_t));
+        if (writer->field[i] == NULL) {
+            sampleLogWriterClose(writer);
+            return -1;
+        }
+    }
+    writer->stream = fopen(path, "wb");
+    if (writer->timestamp == NULL || writer->buffer == NULL ||
+        writer->stream == NULL) {
+        sampleLogWriterClose(writer);
+        return -1;
+    }
+
+    memcpy(file_header, sample_log_magic, sizeof(sample_log_magic));
+    file_header[4] = sample_log_version;
+    file_header[5] = header->type;
+    file_header[6] = writer->field_count;
+    file_header[7] = 0;
+    sampleLogPut32(&file_header[8], header->device_id);
+    sampleLogPut32(&file_header[12], SAMPLE_LOG_BLOCK_SAMPLES);
+    sampleLogPut16(&file_header[16], header->settings_size);
+    if (fwrite(file_header, sizeof(file_header), 1, writer->stream) != 1 ||
+        fwrite(header->settings, 1, header->settings_size, writer->stream) !=
+            header->settings_size) {
+        sampleLogWriterClose(writer);
+        return -1;
+    }
+    return 0;
+}
+
+int8_t sampleLogWriterAppend(struct sample_log_writer_t* writer,
+                             struct sample_t const* samples, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        struct sample_t const* sample = &samples[i];
+        uint32_t index = writer->count;
+        if (sample->type != writer->header.type ||
+            sample->device_id != writer->header.device_id) {
+            continue;
+        }
+        writer->timestamp[index] = sample->timestamp;
+        switch (sample->type) {
+        case sample_type_bme280:
+            writer->field[0][index] = sample->data.bme280.temperature;
+            writer->field[1][index] = sample->data.bme280.pressure;
+            writer->field[2][index] = sample->data.bme280.humidity;
+            break;
+        case sample_type_tsl2561:
+            writer->field[0][index] = sample->data.tsl2561.channel_0;
+            writer->field[1][index] = sample->data.tsl2561.channel_1;
+            break;
+        case sample_type_mcp3002:
+            writer->field[0][index] = sample->data.mcp3002.differential_0;
+            writer->field[1][index] = sample->data.mcp3002.differential_1;
+            writer->field[2][index] = sample->data.mcp3002.single_0;
+            writer->field[3][index] = sample->data.mcp3002.single_1;
+            break;
+        }
+        if (++writer->count == SAMPLE_LOG_BLOCK_SAMPLES &&
+            sampleLogWriteBlock(writer) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int8_t sampleLogWriterFlush(struct sample_log_writer_t* writer) {
+    if (writer->count != 0 && sampleLogWriteBlock(writer) != 0) {
+        return -1;
+    }
+    return fflush(writer->stream) == 0 ? 0 : -1;
+}
+
+int8_t sampleLogWriterClose(struct sample_log_writer_t* writer) {
+    int8_t result = 0;
+    if (writer->stream != NULL) {
+        result = sampleLogWriterFlush(writer);
+        if (fclose(writer->stream) != 0) {
+            result = -1;
+        }
+        writer->stream = NULL;
+    }
+    free(writer->timestamp);
+    free(writer->buffer);
+    writer->timestamp = NULL;
+    writer->buffer = NULL;
+    for (uint8_t i = 0; i < SAMPLE_LOG_FIELD_MAX; i++) {
+        free(writer->field[i]);
+        writer->field[i] = NULL;
+    }
+    return result;
+}
+
+int8_t sampleLogReaderOpen(struct sample_log_reader_t* reader,
+                           char const* path) {
+    struct stat status;
+    memset(reader, 0, sizeof(struct sample_log_reader_t));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &status) != 0 ||
+        (size_t)status.st_size < sample_log_file_header_size) {
+        close(fd);
+        return -1;
+    }
+    void* data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    reader->data = data;
+    reader->size = status.st_size;
+
+    uint8_t const* in = reader->data;
+    reader->header.type = in[5];
+    reader->header.device_id = sampleLogGet32(&in[8]);
+    reader->header.settings_size = sampleLogGet16(&in[16]);
+    reader->field_count = in[6];
+    if (memcmp(in, sample_log_magic, sizeof(sample_log_magic)) != 0 ||
+        in[4] != sample_log_version ||
+        reader->field_count != sampleLogGetFieldCount(in[5]) ||
+        sampleLogGet32(&in[12]) > SAMPLE_LOG_BLOCK_SAMPLES ||
+        reader->header.settings_size > SAMPLE_LOG_SETTINGS_MAX ||
+        sample_log_file_header_size + reader->header.settings_size >
+            reader->size) {
+        sampleLogReaderClose(reader);
+        return -1;
+    }
+    memcpy(reader->header.settings, &in[sample_log_file_header_size],
+           reader->header.settings_size);
+    madvise((void*)reader->data, reader->size, MADV_SEQUENTIAL);
+    if (sampleLogIndexBlocks(reader, sample_log_file_header_size +
+                                         reader->header.settings_size) != 0) {
+        sampleLogReaderClose(reader);
+        return -1;
+    }
+    return 0;
+}
+
+void sampleLogReaderClose(struct sample_log_reader_t* reader) {
+    if (reader->data != NULL) {
+        munmap((void*)reader->data, reader->size);
+    }
+    free(reader->blocks);
+    reader->data = NULL;
+    reader->blocks = NULL;
+    reader->block_count = 0;
+}
+
+uint32_t sampleLogReaderSeek(struct sample_log_reader_t* reader,
+                             uint64_t time) {
+    uint32_t low = 0;
+    uint32_t high = reader->block_count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (reader->blocks[middle].last_time < time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+uint32_t sampleLogReaderDecode(struct sample_log_reader_t* reader,
+                               uint32_t block,
+                               struct sample_log_columns_t* columns) {
+    if (block >= reader->block_count) {
+        return 0;
+    }
+    struct sample_log_block_t const* entry = &reader->blocks[block];
+    uint8_t const* header = &reader->data[entry->offset];
+    uint8_t const* in = &header[sample_log_block_header_size +
+                                (1 + reader->field_count) * sizeof(uint32_t)];
+    uint64_t value;
+
+    // Timestamps are stored as zigzag delta-of-deltas after the first
+    uint8_t const* end = in + sampleLogGet32(&header[24]);
+    if (columns->timestamp != NULL) {
+        uint64_t* timestamp = columns->timestamp;
+        uint64_t time = entry->first_time;
+        int64_t delta = 0;
+        timestamp[0] = time;
+        for (uint32_t i = 1; i < entry->count; i++) {
+            if ((in = sampleLogGetVarint(in, end, &value)) == NULL) {
+                return 0;
+            }
+            delta += sampleLogUnzigzag(value);
+            time += delta;
+            timestamp[i] = time;
+        }
+    }
+    in = end;
+
+    // Fields are stored as zigzag deltas, one column after another
+    for (uint8_t i = 0; i < reader->field_count; i++) {
+        end = in + sampleLogGet32(&header[28 + i * sizeof(uint32_t)]);
+        if (columns->field[i] != NULL) {
+            uint32_t* field = columns->field[i];
+            uint32_t previous = 0;
+            for (uint32_t j = 0; j < entry->count; j++) {
+                if ((in = sampleLogGetVarint(in, end, &value)) == NULL) {
+                    return 0;
+                }
+                previous += (uint32_t)sampleLogUnzigzag(value);
+                field[j] = previous;
+            }
+        }
+        in = end;
+    }
+    return entry->count;
+}
+
+static uint8_t sampleLogGetFieldCount(enum sample_type_t type) {
+    switch (type) {
+    case sample_type_bme280:
+        return 3;
+    case sample_type_tsl2561:
+        return 2;
+    case sample_type_mcp3002:
+        return 4;
+    }
+    return 0;
+}
+
+static int8_t sampleLogWriteBlock(struct sample_log_writer_t* writer) {
+    uint8_t* header = writer->buffer;
+    uint8_t* start = &header[sample_log_block_header_size +
+                             (1 + writer->field_count) * sizeof(uint32_t)];
+    uint8_t* out = start;
+    uint64_t* timestamp = writer->timestamp;
+    int64_t delta = 0;
+    for (uint32_t i = 1; i < writer->count; i++) {
+        int64_t next = (int64_t)(timestamp[i] - timestamp[i - 1]);
+        out = sampleLogPutVarint(out, sampleLogZigzag(next - delta));
+        delta = next;
+    }
+    sampleLogPut32(&header[24], out - start);
+    for (uint8_t i = 0; i < writer->field_count; i++) {
+        uint8_t* column = out;
+        uint32_t* field = writer->field[i];
+        uint32_t previous = 0;
+        for (uint32_t j = 0; j < writer->count; j++) {
+            int32_t difference = (int32_t)(field[j] - previous);
+            out = sampleLogPutVarint(out, sampleLogZigzag(difference));
+            previous = field[j];
+        }
+        sampleLogPut32(&header[28 + i * sizeof(uint32_t)], out - column);
+    }
+    sampleLogPut32(&header[0], out - start);
+    sampleLogPut32(&header[4], writer->count);
+    sampleLogPut64(&header[8], timestamp[0]);
+    sampleLogPut64(&header[16], timestamp[writer->count - 1]);
+    writer->count = 0;
+    size_t size = out - header;
+    return fwrite(header, 1, size, writer->stream) == size ? 0 : -1;
+}
+
+static int8_t sampleLogIndexBlocks(struct sample_log_reader_t* reader,
+                                   size_t offset) {
+    uint32_t capacity = 0;
+    size_t header_size = sample_log_block_header_size +
+                         (1 + reader->field_count) * sizeof(uint32_t);
+    while (offset + header_size <= reader->size) {
+        uint8_t const* header = &reader->data[offset];
+        uint32_t size = sampleLogGet32(&header[0]);
+        uint32_t count = sampleLogGet32(&header[4]);
+        uint64_t columns = 0;
+        for (uint8_t i = 0; i <= reader->field_count; i++) {
+            columns += sampleLogGet32(&header[24 + i * sizeof(uint32_t)]);
+        }
+        // A torn block at the end of a live log is ignored
+        if (size > reader->size - offset - header_size || columns != size ||
+            count == 0 || count > SAMPLE_LOG_BLOCK_SAMPLES) {
+            break;
+        }
+        if (reader->block_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            struct sample_log_block_t* blocks = realloc(
+                reader->blocks, capacity * sizeof(struct sample_log_block_t));
+            if (blocks == NULL) {
+                return -1;
+            }
+            reader->blocks = blocks;
+        }
+        struct sample_log_block_t* block = &reader->blocks[reader->block_count];
+        block->offset = offset;
+        block->size = size;
+        block->count = count;
+        block->first_time = sampleLogGet64(&header[8]);
+        block->last_time = sampleLogGet64(&header[16]);
+        reader->block_count++;
+        reader->sample_count += count;
+        offset += header_size + size;
+    }
+    return 0;
+}
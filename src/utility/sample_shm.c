@@ -0,0 +1,232 @@
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utility/clock.h"
+#include "utility/sample.h"
+#include "utility/sample_shm.h"
+
+static uint32_t const sample_shm_magic = 0x4D485353;
+static uint32_t const sample_shm_version = 1;
+static uint32_t const sample_shm_capacity_max = 1u << 31;
+static uint32_t const sample_shm_retry_max = 64;
+
+static uint32_t sampleShmCapacity(uint32_t capacity);
+
+int8_t sampleShmPublisherOpen(struct sample_shm_publisher_t* publisher,
+                              char const* name, uint32_t capacity) {
+    if (capacity > sample_shm_capacity_max) {
+        return -1;
+    }
+    capacity = sampleShmCapacity(capacity);
+    publisher->size = sizeof(struct sample_shm_region_t) +
+                      (size_t)capacity * sizeof(struct sample_shm_cell_t);
+    publisher->mask = capacity - 1;
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, publisher->size) != 0) {
+        close(fd);
+        return -1;
+    }
+    void* data = mmap(NULL, publisher->size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    publisher->region = data;
+
+    // A restarted publisher carries on where the last one stopped so that
+    // attached readers keep their place, a slot it died writing is closed
+    struct sample_shm_region_t* region = publisher->region;
+    if (atomic_load_explicit(&region->magic, memory_order_acquire) ==
+            sample_shm_magic &&
+        region->version == sample_shm_version &&
+        region->capacity == capacity) {
+        for (uint32_t i = 0; i < SAMPLE_SHM_DEVICE_MAX; i++) {
+            uint32_t sequence = atomic_load_explicit(
+                &region->latest[i].sequence, memory_order_relaxed);
+            if (sequence & 1) {
+                atomic_store_explicit(&region->latest[i].sequence,
+                                      sequence + 1, memory_order_release);
+            }
+        }
+        return 0;
+    }
+    atomic_store_explicit(&region->magic, 0, memory_order_release);
+    memset((uint8_t*)region + offsetof(struct sample_shm_region_t, head), 0,
+           publisher->size - offsetof(struct sample_shm_region_t, head));
+    region->version = sample_shm_version;
+    region->capacity = capacity;
+    atomic_store_explicit(&region->magic, sample_shm_magic,
+                          memory_order_release);
+    return 0;
+}
+
+void sampleShmPublisherClose(struct sample_shm_publisher_t* publisher) {
+    if (publisher->region != NULL) {
+        munmap(publisher->region, publisher->size);
+        publisher->region = NULL;
+    }
+}
+
+void sampleShmPublish(struct sample_shm_publisher_t* publisher,
+                      struct sample_t const* samples, uint32_t count) {
+    struct sample_shm_region_t* region = publisher->region;
+    uint64_t head = atomic_load_explicit(&region->head, memory_order_relaxed);
+    for (uint32_t i = 0; i < count; i++) {
+        // Odd sequence numbers mark a write in progress
+        if (samples[i].device_id < SAMPLE_SHM_DEVICE_MAX) {
+            struct sample_shm_slot_t* slot = &region->latest[samples[i]
+                                                                 .device_id];
+            uint32_t sequence =
+                atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+            atomic_store_explicit(&slot->sequence, sequence + 1,
+                                  memory_order_relaxed);
+            atomic_thread_fence(memory_order_release);
+            slot->sample = samples[i];
+            atomic_store_explicit(&slot->sequence, sequence + 2,
+                                  memory_order_release);
+        }
+
+        // History cells also encode which lap of the ring they hold
+        struct sample_shm_cell_t* cell =
+            &region->history[(head + i) & publisher->mask];
+        atomic_store_explicit(&cell->sequence, 2 * (head + i) + 1,
+                              memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        cell->sample = samples[i];
+        atomic_store_explicit(&cell->sequence, 2 * (head + i) + 2,
+                              memory_order_release);
+    }
+    atomic_store_explicit(&region->head, head + count, memory_order_release);
+    atomic_store_explicit(&region->publish_time, clockGetTime(),
+                          memory_order_relaxed);
+}
+
+int8_t sampleShmRemove(char const* name) {
+    return shm_unlink(name) == 0 ? 0 : -1;
+}
+
+int8_t sampleShmReaderOpen(struct sample_shm_reader_t* reader,
+                           char const* name) {
+    struct stat status;
+    memset(reader, 0, sizeof(struct sample_shm_reader_t));
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &status) != 0 ||
+        (size_t)status.st_size < sizeof(struct sample_shm_region_t)) {
+        close(fd);
+        return -1;
+    }
+    void* data = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    reader->region = data;
+    reader->size = status.st_size;
+
+    struct sample_shm_region_t const* region = reader->region;
+    uint32_t capacity = region->capacity;
+    if (atomic_load_explicit(&region->magic, memory_order_acquire) !=
+            sample_shm_magic ||
+        region->version != sample_shm_version ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        reader->size < sizeof(struct sample_shm_region_t) +
+                           (size_t)capacity *
+                               sizeof(struct sample_shm_cell_t)) {
+        sampleShmReaderClose(reader);
+        return -1;
+    }
+    reader->mask = capacity - 1;
+    reader->cursor = atomic_load_explicit(&region->head, memory_order_acquire);
+    return 0;
+}
+
+void sampleShmReaderClose(struct sample_shm_reader_t* reader) {
+    if (reader->region != NULL) {
+        munmap((void*)reader->region, reader->size);
+        reader->region = NULL;
+    }
+}
+
+int8_t sampleShmReaderGetLatest(struct sample_shm_reader_t* reader,
+                                uint32_t device_id, struct sample_t* sample) {
+    if (device_id >= SAMPLE_SHM_DEVICE_MAX) {
+        return -1;
+    }
+    struct sample_shm_slot_t const* slot = &reader->region->latest[device_id];
+
+    // Give up rather than spin if the publisher keeps the slot busy
+    for (uint32_t i = 0; i < sample_shm_retry_max; i++) {
+        uint32_t sequence =
+            atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        *sample = slot->sample;
+        atomic_thread_fence(memory_order_acquire);
+        if (!(sequence & 1) &&
+            sequence == atomic_load_explicit(&slot->sequence,
+                                             memory_order_relaxed)) {
+            return sequence == 0 ? -1 : 0;
+        }
+    }
+    return -1;
+}
+
+uint32_t sampleShmReaderRead(struct sample_shm_reader_t* reader,
+                             struct sample_t* samples, uint32_t count) {
+    struct sample_shm_region_t const* region = reader->region;
+    uint64_t head = atomic_load_explicit(&region->head, memory_order_acquire);
+    uint64_t cursor = reader->cursor;
+    uint32_t read = 0;
+
+    // Fell a full lap behind, skip what has been overwritten already
+    if (cursor > head) {
+        cursor = head;
+    } else if (head - cursor > reader->mask + 1) {
+        reader->lost += head - cursor - (reader->mask + 1);
+        cursor = head - (reader->mask + 1);
+    }
+    for (; read < count && cursor < head; cursor++) {
+        struct sample_shm_cell_t const* cell =
+            &region->history[cursor & reader->mask];
+        uint64_t expected = 2 * cursor + 2;
+        if (atomic_load_explicit(&cell->sequence, memory_order_acquire) !=
+            expected) {
+            reader->lost++;
+            continue;
+        }
+        samples[read] = cell->sample;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&cell->sequence, memory_order_relaxed) !=
+            expected) {
+            reader->lost++;
+            continue;
+        }
+        read++;
+    }
+    reader->cursor = cursor;
+    return read;
+}
+
+uint64_t sampleShmReaderGetPublishTime(struct sample_shm_reader_t* reader) {
+    return atomic_load_explicit(&reader->region->publish_time,
+                                memory_order_relaxed);
+}
+
+static uint32_t sampleShmCapacity(uint32_t capacity) {
+    uint32_t power = 1;
+    while (power < capacity) {
+        power <<= 1;
+    }
+    return power;
+}
@@ -0,0 +1,271 @@
+#include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+#include "utility/clock.h"
+#include "utility/scheduler.h"
+
+static uint64_t const scheduler_retry_time = 500000;
+
+static void schedulerStartTask(struct scheduler_task_t* task, uint64_t now);
+static void schedulerArmTimer(struct scheduler_t* scheduler, uint64_t time);
+
+int8_t schedulerInitialize(struct scheduler_t* scheduler) {
+    struct epoll_event event = {
+        .events = EPOLLIN,
+    };
+    scheduler->tasks = NULL;
+    atomic_init(&scheduler->running, 0);
+    scheduler->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    scheduler->event_fd = eventfd(0, EFD_CLOEXEC);
+    scheduler->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (scheduler->timer_fd < 0 || scheduler->event_fd < 0 ||
+        scheduler->epoll_fd < 0) {
+        schedulerFinalize(scheduler);
+        return -1;
+    }
+    event.data.ptr = &scheduler->timer_fd;
+    epoll_ctl(scheduler->epoll_fd, EPOLL_CTL_ADD, scheduler->timer_fd, &event);
+    event.data.ptr = &scheduler->event_fd;
+    epoll_ctl(scheduler->epoll_fd, EPOLL_CTL_ADD, scheduler->event_fd, &event);
+    return 0;
+}
+
+void schedulerFinalize(struct scheduler_t* scheduler) {
+    if (scheduler->timer_fd >= 0) {
+        close(scheduler->timer_fd);
+    }
+    if (scheduler->event_fd >= 0) {
+        close(scheduler->event_fd);
+    }
+    if (scheduler->epoll_fd >= 0) {
+        close(scheduler->epoll_fd);
+    }
+    scheduler->timer_fd = -1;
+    scheduler->event_fd = -1;
+    scheduler->epoll_fd = -1;
+}
+
+void schedulerAddTask(struct scheduler_t* scheduler,
+                      struct scheduler_task_t* task) {
+    task->pending = 0;
+    task->start_time = 0;
+    task->ready_time = 0;
+    task->last_start = 0;
+    task->count = 0;
+    task->period_mean = 0.0;
+    task->period_m2 = 0.0;
+    task->latency_max = 0;
+    task->next = scheduler->tasks;
+    scheduler->tasks = task;
+}
+
+void schedulerSetTaskPeriod(struct scheduler_task_t* task, uint64_t period) {
+    // A task without a period stays idle until it gets one
+    uint64_t now = clockGetTime();
+    if (task->period == 0 || task->last_start + period < task->start_time) {
+        task->start_time = task->last_start + period > now
+                               ? task->last_start + period
+                               : now;
+    }
+    task->period = period;
+}
+
+int8_t schedulerAddWatch(struct scheduler_t* scheduler,
+                         struct scheduler_watch_t* watch) {
+    struct epoll_event event = {
+        .events = watch->events,
+        .data.ptr = watch,
+    };
+    if (epoll_ctl(scheduler->epoll_fd, EPOLL_CTL_ADD, watch->fd, &event) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+void schedulerRemoveWatch(struct scheduler_t* scheduler,
+                          struct scheduler_watch_t* watch) {
+    epoll_ctl(scheduler->epoll_fd, EPOLL_CTL_DEL, watch->fd, NULL);
+}
+
+void schedulerRun(struct scheduler_t* scheduler) {
+    struct epoll_event events[SCHEDULER_EVENT_MAX];
+    uint64_t now = clockGetTime();
+    uint64_t deadline;
+    uint64_t value;
+    atomic_store(&scheduler->running, 1);
+    for (struct scheduler_task_t* task = scheduler->tasks; task != NULL;
+         task = task->next) {
+        task->start_time = now;
+        task->pending = 0;
+    }
+    while (atomic_load(&scheduler->running)) {
+        deadline = UINT64_MAX;
+        now = clockGetTime();
+        for (struct scheduler_task_t* task = scheduler->tasks; task != NULL;
+             task = task->next) {
+            if (!task->pending && task->period != 0 &&
+                now >= task->start_time) {
+                schedulerStartTask(task, now);
+            }
+        }
+        now = clockGetTime();
+        for (struct scheduler_task_t* task = scheduler->tasks; task != NULL;
+             task = task->next) {
+            if (task->pending && now >= task->ready_time) {
+                if (task->fetch(task) == 0) {
+                    task->pending = 0;
+                    if (task->callback != NULL) {
+                        task->callback(task);
+                    }
+                } else {
+                    task->ready_time = now + scheduler_retry_time;
+                }
+            }
+            if (task->pending && task->ready_time < deadline) {
+                deadline = task->ready_time;
+            } else if (!task->pending && task->period != 0 &&
+                       task->start_time < deadline) {
+                deadline = task->start_time;
+            }
+        }
+        schedulerArmTimer(scheduler, deadline);
+        int count = epoll_wait(scheduler->epoll_fd, events,
+                               SCHEDULER_EVENT_MAX, -1);
+        for (int i = 0; i < count; i++) {
+            int* fd = events[i].data.ptr;
+            if (fd != &scheduler->timer_fd && fd != &scheduler->event_fd) {
+                struct scheduler_watch_t* watch = events[i].data.ptr;
+                watch->callback(watch, events[i].events);
+            } else if (read(*fd, &value, sizeof(value)) < 0) {
+                continue;
+            }
+        }
+    }
+}
+
+void schedulerStop(struct scheduler_t* scheduler) {
+    uint64_t value = 1;
+    atomic_store(&scheduler->running, 0);
+    if (write(scheduler->event_fd, &value, sizeof(value)) < 0) {
+        return;
+    }
+}
+
+void schedulerGetStatistics(struct scheduler_task_t* task,
+                            struct scheduler_statistics_t* statistics) {
+    statistics->count = task->count;
+    statistics->period = task->period_mean;
+    statistics->jitter =
+        task->count > 2 ? sqrt(task->period_m2 / (task->count - 2)) : 0.0;
+    statistics->latency_max = task->latency_max;
+}
+
+static uint64_t schedulerStartBme280(struct scheduler_task_t* task) {
+    return bme280StartConversion(task->device);
+}
+
+static int8_t schedulerFetchBme280(struct scheduler_task_t* task) {
+    return bme280FetchDeviceData(task->device, task->data);
+}
+
+static uint64_t schedulerStartTsl2561(struct scheduler_task_t* task) {
+    return tsl2561StartConversion(task->device);
+}
+
+static int8_t schedulerFetchTsl2561(struct scheduler_task_t* task) {
+    return tsl2561FetchDeviceData(task->device, task->data);
+}
+
+static uint64_t schedulerStartMcp3002(struct scheduler_task_t* task) {
+    (void)task;
+    return clockGetTime();
+}
+
+static int8_t schedulerFetchMcp3002(struct scheduler_task_t* task) {
+    mcp3002ReadDeviceData(task->device, task->data);
+    return 0;
+}
+
+void schedulerInitializeBme280Task(struct scheduler_task_t* task,
+                                   struct bme280_t* device,
+                                   struct bme280_data_t* data,
+                                   uint64_t period) {
+    task->period = period;
+    task->start = schedulerStartBme280;
+    task->fetch = schedulerFetchBme280;
+    task->callback = NULL;
+    task->device = device;
+    task->data = data;
+    task->context = NULL;
+}
+
+void schedulerInitializeTsl2561Task(struct scheduler_task_t* task,
+                                    struct tsl2561_t* device,
+                                    struct tsl2561_data_t* data,
+                                    uint64_t period) {
+    task->period = period;
+    task->start = schedulerStartTsl2561;
+    task->fetch = schedulerFetchTsl2561;
+    task->callback = NULL;
+    task->device = device;
+    task->data = data;
+    task->context = NULL;
+}
+
+void schedulerInitializeMcp3002Task(struct scheduler_task_t* task,
+                                    struct mcp3002_t* device,
+                                    struct mcp3002_data_t* data,
+                                    uint64_t period) {
+    task->period = period;
+    task->start = schedulerStartMcp3002;
+    task->fetch = schedulerFetchMcp3002;
+    task->callback = NULL;
+    task->device = device;
+    task->data = data;
+    task->context = NULL;
+}
+
+static void schedulerStartTask(struct scheduler_task_t* task, uint64_t now) {
+    uint64_t latency = now - task->start_time;
+    if (latency > task->latency_max) {
+        task->latency_max = latency;
+    }
+    if (task->count > 0) {
+        double interval = (double)(now - task->last_start);
+        double delta = interval - task->period_mean;
+        task->period_mean += delta / task->count;
+        task->period_m2 += delta * (interval - task->period_mean);
+    }
+    task->last_start = now;
+    task->count++;
+    task->ready_time = task->start(task);
+    task->pending = 1;
+    task->start_time += task->period;
+    if (task->start_time + task->period < now) {
+        task->start_time = now;
+    }
+}
+
+static void schedulerArmTimer(struct scheduler_t* scheduler, uint64_t time) {
+    struct itimerspec timer = {
+        .it_interval = {0, 0},
+        .it_value = {0, 0},
+    };
+    if (time != UINT64_MAX) {
+        if (time == 0) {
+            time = 1;
+        }
+        timer.it_value.tv_sec = time / 1000000000;
+        timer.it_value.tv_nsec = time % 1000000000;
+    }
+    timerfd_settime(scheduler->timer_fd, TFD_TIMER_ABSTIME, &timer, NULL);
+}
@@ -0,0 +1,183 @@
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef PIGPIO_ENABLE
+#include "pigpio.h"
+#endif
+#include "device/bme280.h"
+#include "device/mcp3002.h"
+#include "device/tsl2561.h"
+#include "interface/i2c.h"
+#include "interface/spi.h"
+#include "utility/fleet.h"
+#include "utility/hub.h"
+#include "utility/scheduler.h"
+
+static char const* const hubd_default_path = "/tmp/sensor_hub.sock";
+static uint32_t const hubd_clock_speed = 1000000;
+
+static struct scheduler_t scheduler;
+static struct hub_t hub;
+
+static void hubdStop(int signal_number) {
+    (void)signal_number;
+    schedulerStop(&scheduler);
+}
+
+static void hubdUsage(char const* name) {
+    fprintf(stderr,
+            "usage: %s [-s socket] [-c cache] [-b bus.cs] [-t bus:address] "
+            "[-m bus.cs]\n"
+            "  -b  BME280 on SPI, -t TSL2561 on I2C, -m MCP3002 on SPI\n"
+            "  devices are numbered from 0 in the order given\n",
+            name);
+}
+
+int main(int argc, char** argv) {
+    struct bme280_t bme280[HUB_DEVICE_MAX];
+    struct tsl2561_t tsl2561[HUB_DEVICE_MAX];
+    struct mcp3002_t mcp3002[HUB_DEVICE_MAX];
+    struct fleet_device_t devices[HUB_DEVICE_MAX];
+    spi_device_t mcp3002_spi[HUB_DEVICE_MAX];
+    uint32_t device_id[HUB_DEVICE_MAX];
+    uint32_t mcp3002_id[HUB_DEVICE_MAX];
+    uint32_t device_count = 0;
+    uint32_t mcp3002_count = 0;
+    char const* path = hubd_default_path;
+    char const* cache_path = NULL;
+    int option;
+
+#ifdef PIGPIO_ENABLE
+    gpioInitialise();
+#endif
+
+    // Open every bus device up front, initialization happens in parallel
+    while ((option = getopt(argc, argv, "s:c:b:t:m:")) != -1) {
+        uint32_t id = device_count + mcp3002_count;
+        unsigned bus;
+        unsigned slave;
+        if ((option == 'b' || option == 't' || option == 'm') &&
+            id == HUB_DEVICE_MAX) {
+            fprintf(stderr, "At most %u devices\n", HUB_DEVICE_MAX);
+            return 1;
+        }
+        if (option == 's') {
+            path = optarg;
+        } else if (option == 'c') {
+            cache_path = optarg;
+        } else if ((option == 'b' || option == 'm') &&
+                   sscanf(optarg, "%u.%u", &bus, &slave) == 2) {
+            struct spi_settings_t settings = {
+                .bus_number = bus,
+                .slave_number = slave,
+                .clock_speed = hubd_clock_speed,
+                .mode_number = 0,
+                .active_high = spi_active_high_disable,
+            };
+            spi_device_t spi_device = spiInitialize(&settings);
+            if (spi_device == 0) {
+                fprintf(stderr, "Failed to open SPI %s\n", optarg);
+                return 1;
+            }
+            if (option == 'b') {
+                devices[device_count].type = fleet_device_bme280;
+                devices[device_count].device = &bme280[device_count];
+                devices[device_count].spi_device = spi_device;
+                device_id[device_count++] = id;
+            } else {
+                mcp3002_spi[mcp3002_count] = spi_device;
+                mcp3002_id[mcp3002_count++] = id;
+            }
+        } else if (option == 't' &&
+                   sscanf(optarg, "%u:%x", &bus, &slave) == 2) {
+            struct i2c_settings_t settings = {
+                .bus_number = bus,
+                .address = slave,
+            };
+            i2c_device_t i2c_device = i2cInitialize(&settings);
+            if (i2c_device == 0) {
+                fprintf(stderr, "Failed to open I2C %s\n", optarg);
+                return 1;
+            }
+            devices[device_count].type = fleet_device_tsl2561;
+            devices[device_count].device = &tsl2561[device_count];
+            devices[device_count].i2c_device = i2c_device;
+            device_id[device_count++] = id;
+        } else {
+            hubdUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    struct bme280_cache_t cache;
+    struct fleet_settings_t fleet_settings = {
+        .bme280_cache = &cache,
+    };
+    bme280CacheInitialize(&cache);
+    if (cache_path != NULL) {
+        bme280CacheLoad(&cache, cache_path);
+    }
+    fleetInitialize(devices, device_count, &fleet_settings);
+    if (cache_path != NULL && cache.modified) {
+        bme280CacheSave(&cache, cache_path);
+    }
+
+    if (schedulerInitialize(&scheduler) != 0 ||
+        hubInitialize(&hub, &scheduler, path) != 0) {
+        fprintf(stderr, "Failed to listen on %s\n", path);
+        return 1;
+    }
+    struct bme280_settings_t bme280_settings = {
+        .mode = bme280_mode_forced,
+        .osr_temp = bme280_osr_temp_x1,
+        .osr_pres = bme280_osr_pres_x1,
+        .osr_hum = bme280_osr_hum_x1,
+        .standby = bme280_standbytime_1s,
+        .filter = bme280_filter_off,
+    };
+    for (uint32_t i = 0; i < device_count; i++) {
+        if (devices[i].status < 0) {
+            fprintf(stderr, "Device %u did not come up\n", device_id[i]);
+            continue;
+        }
+        if (devices[i].type == fleet_device_bme280) {
+            bme280SetDeviceSettings(devices[i].device, &bme280_settings);
+            hubAddBme280(&hub, device_id[i], devices[i].device);
+        } else {
+            hubAddTsl2561(&hub, device_id[i], devices[i].device);
+        }
+    }
+    struct mcp3002_settings_t mcp3002_settings = {
+        .base_voltage = 3300,
+    };
+    for (uint32_t i = 0; i < mcp3002_count; i++) {
+        mcp3002Initialize(&mcp3002[i], mcp3002_spi[i]);
+        mcp3002SetDeviceSettings(&mcp3002[i], &mcp3002_settings);
+        hubAddMcp3002(&hub, mcp3002_id[i], &mcp3002[i]);
+    }
+
+    // Devices stay idle until a client subscribes to them
+    signal(SIGINT, hubdStop);
+    signal(SIGTERM, hubdStop);
+    schedulerRun(&scheduler);
+
+    hubFinalize(&hub);
+    schedulerFinalize(&scheduler);
+    for (uint32_t i = 0; i < device_count; i++) {
+        if (devices[i].type == fleet_device_bme280) {
+            spiFinalize(devices[i].spi_device);
+        } else {
+            i2cFinalize(devices[i].i2c_device);
+        }
+    }
+    for (uint32_t i = 0; i < mcp3002_count; i++) {
+        spiFinalize(mcp3002_spi[i]);
+    }
+#ifdef PIGPIO_ENABLE
+    gpioTerminate();
+#endif
+    return 0;
+}